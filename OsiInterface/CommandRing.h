@@ -0,0 +1,68 @@
+#pragma once
+
+#if !defined(OSI_NO_DEBUGGER)
+
+#include <atomic>
+#include <cstddef>
+
+namespace dse
+{
+	// Lock-free single producer/single consumer ring of fixed-size commands.
+	// Slots are exposed by index, so payloads that don't fit in T can be kept
+	// in a parallel array by the owner of the ring.
+	template <class T, std::size_t Capacity>
+	class CommandRing
+	{
+		static_assert((Capacity & (Capacity - 1)) == 0, "Ring capacity must be a power of two");
+
+	public:
+		// Returns the slot of the next free entry; fails if the ring is full
+		inline bool TryReserve(std::size_t & slot) const
+		{
+			auto head = head_.load(std::memory_order_relaxed);
+			auto tail = tail_.load(std::memory_order_acquire);
+			if (head - tail == Capacity) {
+				return false;
+			}
+
+			slot = head & (Capacity - 1);
+			return true;
+		}
+
+		// Makes the reserved entry visible to the consumer
+		inline void Publish()
+		{
+			head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		// Returns the slot of the oldest published entry; fails if the ring is empty
+		inline bool Peek(std::size_t & slot) const
+		{
+			auto tail = tail_.load(std::memory_order_relaxed);
+			auto head = head_.load(std::memory_order_acquire);
+			if (head == tail) {
+				return false;
+			}
+
+			slot = tail & (Capacity - 1);
+			return true;
+		}
+
+		inline void Consume()
+		{
+			tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		inline T & operator [] (std::size_t slot)
+		{
+			return items_[slot];
+		}
+
+	private:
+		T items_[Capacity];
+		alignas(64) std::atomic<std::size_t> head_{ 0 };
+		alignas(64) std::atomic<std::size_t> tail_{ 0 };
+	};
+}
+
+#endif
@@ -3,6 +3,7 @@
 #include "stdafx.h"
 #include "CustomFunctions.h"
 #include "OsirisProxy.h"
+#include "StoryPreprocessor.h"
 #include <fstream>
 #include <sstream>
 
@@ -12,58 +13,58 @@ namespace dse {
 CustomFunction::~CustomFunction()
 {}
 
-bool CustomFunction::ValidateArgs(OsiArgumentDesc const & params) const
+// All GUID types are accepted interchangeably; CharacterGuid..LevelTemplateGuid
+// immediately follow GuidString in ValueType, so this is a single range check
+inline ValueType NormalizeGuidType(ValueType type)
 {
-	if (params.Count() != params_.size()) {
-		OsiError("Function " << name_  << "/" << params_.size() << ": Argument count mismatch");
-		return false;
-	}
+	return (type >= ValueType::GuidString && type <= ValueType::LevelTemplateGuid)
+		? ValueType::GuidString
+		: type;
+}
 
-	for (auto i = 0; i < params_.size(); i++) {
-		auto const & value = params.Get(i);
+void CustomFunction::CompileArgTypes()
+{
+	argTypes_.resize(params_.size());
+	for (std::size_t i = 0; i < params_.size(); i++) {
 		auto const & param = params_[i];
-		if (!ValidateParam(param, value)) {
-			return false;
+		if (param.Type == ValueType::None
+			|| param.Dir == FunctionArgumentDirection::Out) {
+			argTypes_[i] = ArgUnchecked;
+		} else {
+			argTypes_[i] = (uint8_t)NormalizeGuidType(param.Type);
 		}
 	}
-
-	return true;
 }
 
-bool CustomFunction::ValidateParam(CustomFunctionParam const & param, OsiArgumentValue const & value) const
+bool CustomFunction::ValidateArgs(OsiArgumentDesc const & params) const
 {
-	if (param.Type == ValueType::None
-		|| param.Dir == FunctionArgumentDirection::Out) {
-		return true;
-	}
-
-	auto typeId = value.TypeId;
-	if (typeId == ValueType::CharacterGuid
-		|| typeId == ValueType::ItemGuid
-		|| typeId == ValueType::TriggerGuid
-		|| typeId == ValueType::SplineGuid
-		|| typeId == ValueType::LevelTemplateGuid) {
-		typeId = ValueType::GuidString;
-	}
-
-	auto paramTypeId = param.Type;
-	if (paramTypeId == ValueType::CharacterGuid
-		|| paramTypeId == ValueType::ItemGuid
-		|| paramTypeId == ValueType::TriggerGuid
-		|| paramTypeId == ValueType::SplineGuid
-		|| paramTypeId == ValueType::LevelTemplateGuid) {
-		paramTypeId = ValueType::GuidString;
+	auto numArgs = (uint32_t)argTypes_.size();
+	auto arg = &params;
+	uint32_t i = 0;
+	for (; i < numArgs && arg != nullptr; i++, arg = arg->NextParam) {
+		auto expected = argTypes_[i];
+		if (expected != ArgUnchecked
+			&& expected != (uint8_t)NormalizeGuidType(arg->Value.TypeId)) {
+			ReportArgTypeMismatch(i, arg->Value.TypeId);
+			return false;
+		}
 	}
 
-	if (typeId != paramTypeId) {
-		OsiError("Function " << name_ << "/" << params_.size() << ": Argument '" << param.Name
-			<< "' type mismatch; expected " << (unsigned)paramTypeId << ", got " << (unsigned)typeId);
+	if (i != numArgs || arg != nullptr) {
+		OsiError("Function " << name_  << "/" << params_.size() << ": Argument count mismatch");
 		return false;
 	}
 
 	return true;
 }
 
+void CustomFunction::ReportArgTypeMismatch(uint32_t index, ValueType type) const
+{
+	OsiError("Function " << name_ << "/" << params_.size() << ": Argument '" << params_[index].Name
+		<< "' type mismatch; expected " << (unsigned)argTypes_[index] 
+		<< ", got " << (unsigned)NormalizeGuidType(type));
+}
+
 void CustomFunction::GenerateHeader(std::stringstream & ss) const
 {
 	switch (handle_.type()) {
@@ -386,85 +387,94 @@ STDString CustomFunctionManager::GenerateHeaders() const
 	return STDString(ss.str());
 }
 
-void CustomFunctionManager::PreProcessStory(STDString const & original, STDString & postProcessed)
+namespace
 {
-	STDString ph1;
-	ph1.reserve(original.size());
-	postProcessed.reserve(original.size());
+	// Read-only memory mapped view of a file
+	class MappedFile
+	{
+	public:
+		MappedFile(wchar_t const * path)
+		{
+			file_ = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (file_ == INVALID_HANDLE_VALUE) return;
+
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file_, &size)) return;
+
+			valid_ = true;
+			// Empty files cannot be mapped
+			if (size.QuadPart == 0) return;
+
+			mapping_ = CreateFileMappingW(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping_ == NULL) {
+				valid_ = false;
+				return;
+			}
 
-	std::size_t pos = 0;
-	while (pos < original.size()) {
-		auto next = original.find("/* [OSITOOLS_ONLY]", pos);
-		if (next == std::string::npos) {
-			ph1 += original.substr(pos);
-			break;
-		}
+			view_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+			if (view_ == nullptr) {
+				valid_ = false;
+				return;
+			}
 
-		auto end = original.find("*/", next);
-		if (end == std::string::npos) {
-			ph1 += original.substr(pos);
-			break;
+			size_ = (std::size_t)size.QuadPart;
 		}
 
-		ph1 += original.substr(pos, next - pos);
-		ph1 += original.substr(next + 19, end - next - 19);
-		pos = end + 2;
-	}
+		~MappedFile()
+		{
+			if (view_ != nullptr) UnmapViewOfFile(view_);
+			if (mapping_ != NULL) CloseHandle(mapping_);
+			if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+		}
 
-	pos = 0;
-	while (pos < ph1.size()) {
-		auto next = ph1.find("// [BEGIN_NO_OSITOOLS]", pos);
-		if (next == std::string::npos) {
-			postProcessed += ph1.substr(pos);
-			break;
+		inline bool IsValid() const
+		{
+			return valid_;
 		}
 
-		auto end = ph1.find("// [END_NO_OSITOOLS]", next);
-		if (end == std::string::npos) {
-			postProcessed += ph1.substr(pos);
-			break;
+		inline std::string_view Contents() const
+		{
+			return std::string_view(reinterpret_cast<char const *>(view_), size_);
 		}
 
-		postProcessed += ph1.substr(pos, next - pos);
-		pos = end + 21;
-	}
+	private:
+		HANDLE file_{ INVALID_HANDLE_VALUE };
+		HANDLE mapping_{ NULL };
+		void * view_{ nullptr };
+		std::size_t size_{ 0 };
+		bool valid_{ false };
+	};
+}
+
+void CustomFunctionManager::PreProcessStory(std::string_view original, STDString & postProcessed, bool processMarkers)
+{
+	PreprocessStorySource(original, postProcessed, processMarkers);
 }
 
 void CustomFunctionManager::PreProcessStory(wchar_t const * path)
 {
-	STDString original;
 	STDString postProcessed;
 
 	{
-		std::ifstream f(path, std::ios::in | std::ios::binary);
-		if (!f.good()) return;
+		MappedFile story(path);
+		if (!story.IsValid()) return;
 
-		f.seekg(0, std::ios::end);
-		original.resize(f.tellg());
-		f.seekg(0, std::ios::beg);
-		f.read(original.data(), original.size());
+		bool preprocess = esv::ExtensionState::Get().HasFeatureFlag("Preprocessor");
+		PreProcessStory(story.Contents(), postProcessed, preprocess);
 	}
 
-	// Clear compile trace flags to avoid large compile traces
-	auto debugPos = original.find("option compile_trace\r\n");
-	if (debugPos != std::string::npos) {
-		for (std::size_t i = debugPos; i < debugPos + 20; i++) {
-			original[i] = ' ';
-		}
+	HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		ERR(L"CustomFunctionManager::PreProcessStory(): Could not open '%s' for writing: error %d", path, GetLastError());
+		return;
 	}
 
-	if (esv::ExtensionState::Get().HasFeatureFlag("Preprocessor")) {
-		PreProcessStory(original, postProcessed);
-	} else {
-		postProcessed = original;
+	DWORD written;
+	if (!WriteFile(file, postProcessed.data(), (DWORD)postProcessed.size(), &written, NULL)) {
+		ERR(L"CustomFunctionManager::PreProcessStory(): Failed to write '%s': error %d", path, GetLastError());
 	}
 
-	{
-		std::ofstream f(path, std::ios::out | std::ios::binary);
-		if (!f.good()) return;
-
-		f.write(postProcessed.data(), postProcessed.size());
-	}
+	CloseHandle(file);
 }
 
 
@@ -499,12 +509,18 @@ struct CustomEventGuard
 
 void CustomFunctionInjector::ThrowEvent(FunctionHandle handle, OsiArgumentDesc * args) const
 {
-	auto it = divToOsiMappings_.find(handle);
-	if (it != divToOsiMappings_.end()) {
+	uint32_t osiHandle;
+	if (FindMapping(divToOsiMappings_, handle, osiHandle)) {
 		CustomEventGuard guard;
 		if (guard.CanThrowEvent()) {
 			auto osiris = gOsirisProxy->GetDynamicGlobals().OsirisObject;
-			gOsirisProxy->GetWrappers().Event.CallOriginal(osiris, it->second, args);
+			if (gOsirisProxy->IsTracingStory()) {
+				// Go through the event hooks, so the event is traced if no story code is running
+				gOsirisProxy->GetWrappers().Event.CallWithHooks(osiris, osiHandle, args);
+			} else {
+				StoryCallScope storyCall;
+				gOsirisProxy->GetWrappers().Event.CallOriginal(osiris, osiHandle, args);
+			}
 		} else {
 			OsiError("Maximum Osiris event depth (" << gCustomEventDepth << ") exceeded");
 		}
@@ -567,6 +583,21 @@ void CustomFunctionInjector::CreateOsirisSymbolMap(MappingInfo ** Mappings, uint
 	}
 }
 
+void CustomFunctionInjector::AddMapping(std::vector<HandleMapping> & mappings, FunctionHandle from, uint32_t to)
+{
+	uint32_t slot;
+	if (!GetMappingSlot(from, slot)) {
+		ERR("CustomFunctionInjector::AddMapping(): Handle %08x is outside of the custom function range", (uint32_t)from);
+		return;
+	}
+
+	if (slot >= mappings.size()) {
+		mappings.resize(slot + 1);
+	}
+
+	mappings[slot] = HandleMapping{ from, to };
+}
+
 void CustomFunctionInjector::OnAfterGetFunctionMappings(void * Osiris, MappingInfo ** Mappings, uint32_t * MappingCount)
 {
 	CreateOsirisSymbolMap(Mappings, MappingCount);
@@ -584,8 +615,8 @@ void CustomFunctionInjector::OnAfterGetFunctionMappings(void * Osiris, MappingIn
 		if (mapped == nullptr) {
 			(*Mappings)[outputIndex++] = mapping;
 		} else {
-			osiToDivMappings_.insert(std::make_pair(mapping.Id, mapped->Handle()));
-			divToOsiMappings_.insert(std::make_pair(mapped->Handle(), mapping.Id));
+			AddMapping(osiToDivMappings_, mapping.Id, mapped->Handle());
+			AddMapping(divToOsiMappings_, mapped->Handle(), mapping.Id);
 #if 0
 			DEBUG("Function mapping (%s): %08x --> %08x", mapping.Name, mapping.Id, (unsigned int)mapped->Handle());
 #endif
@@ -600,9 +631,9 @@ void CustomFunctionInjector::OnAfterGetFunctionMappings(void * Osiris, MappingIn
 
 bool CustomFunctionInjector::CallWrapper(std::function<bool (uint32_t, OsiArgumentDesc *)> const & next, uint32_t handle, OsiArgumentDesc * params)
 {
-	auto it = osiToDivMappings_.find(handle);
-	if (it != osiToDivMappings_.end()) {
-		return functions_.Call(it->second, *params);
+	uint32_t divHandle;
+	if (FindMapping(osiToDivMappings_, handle, divHandle)) {
+		return functions_.Call(divHandle, *params);
 	} else {
 		return next(handle, params);
 	}
@@ -610,9 +641,9 @@ bool CustomFunctionInjector::CallWrapper(std::function<bool (uint32_t, OsiArgume
 
 bool CustomFunctionInjector::QueryWrapper(std::function<bool(uint32_t, OsiArgumentDesc *)> const & next, uint32_t handle, OsiArgumentDesc * params)
 {
-	auto it = osiToDivMappings_.find(handle);
-	if (it != osiToDivMappings_.end()) {
-		return functions_.Query(it->second, *params);
+	uint32_t divHandle;
+	if (FindMapping(osiToDivMappings_, handle, divHandle)) {
+		return functions_.Query(divHandle, *params);
 	} else {
 		return next(handle, params);
 	}
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <functional>
@@ -109,7 +110,9 @@ namespace dse
 	public:
 		inline CustomFunction(STDString const & name, std::vector<CustomFunctionParam> params)
 			: name_(name), params_(params)
-		{}
+		{
+			CompileArgTypes();
+		}
 
 		virtual ~CustomFunction();
 
@@ -144,11 +147,17 @@ namespace dse
 		void GenerateHeader(std::stringstream & ss) const;
 
 	private:
+		// Argument type is not checked (ANY type or output parameter)
+		static constexpr uint8_t ArgUnchecked = 0xff;
+
 		STDString name_;
 		std::vector<CustomFunctionParam> params_;
+		// Expected type of each argument with GUID types normalized to GuidString
+		std::vector<uint8_t> argTypes_;
 		FunctionHandle handle_;
 
-		bool ValidateParam(CustomFunctionParam const & param, OsiArgumentValue const & value) const;
+		void CompileArgTypes();
+		void ReportArgTypeMismatch(uint32_t index, ValueType type) const;
 	};
 
 	class CustomCallBase : public CustomFunction
@@ -252,7 +261,7 @@ namespace dse
 
 		STDString GenerateHeaders() const;
 		void PreProcessStory(wchar_t const * path);
-		void PreProcessStory(STDString const & original, STDString & postProcessed);
+		void PreProcessStory(std::string_view original, STDString & postProcessed, bool processMarkers);
 
 	private:
 		struct DynamicFunctionBindingInfo
@@ -312,10 +321,46 @@ namespace dse
 		std::wstring storyHeaderPath_;
 		HANDLE storyHeaderFile_{ NULL };
 		bool extendingStory_{ false };
-		std::unordered_map<uint32_t, FunctionHandle> osiToDivMappings_;
-		std::unordered_map<FunctionHandle, uint32_t> divToOsiMappings_;
+
+		struct HandleMapping
+		{
+			// Full handle of the mapping source; 0 if the slot is unmapped
+			uint32_t From{ 0 };
+			uint32_t To{ 0 };
+		};
+
+		// Flat handle mapping tables, indexed by GetMappingSlot()
+		std::vector<HandleMapping> osiToDivMappings_;
+		std::vector<HandleMapping> divToOsiMappings_;
 		std::vector<OsiSymbolInfo> osiSymbols_;
 
+		// Maps handles in the custom function class ID range (CallClassIdMin..EventClassIdMax)
+		// to a dense table index; returns false for all other handles.
+		static inline bool GetMappingSlot(FunctionHandle handle, uint32_t & slot)
+		{
+			auto classIndex = handle.classIndex();
+			if (classIndex < CustomFunctionManager::CallClassIdMin
+				|| classIndex > CustomFunctionManager::EventClassIdMax) {
+				return false;
+			}
+
+			slot = ((classIndex - CustomFunctionManager::CallClassIdMin) << 10) + handle.functionIndex();
+			return true;
+		}
+
+		static void AddMapping(std::vector<HandleMapping> & mappings, FunctionHandle from, uint32_t to);
+
+		static inline bool FindMapping(std::vector<HandleMapping> const & mappings, FunctionHandle from, uint32_t & to)
+		{
+			uint32_t slot;
+			if (GetMappingSlot(from, slot) && slot < mappings.size() && mappings[slot].From == (uint32_t)from) {
+				to = mappings[slot].To;
+				return true;
+			} else {
+				return false;
+			}
+		}
+
 		void CreateOsirisSymbolMap(MappingInfo ** Mappings, uint32_t * MappingCount);
 		void OnAfterGetFunctionMappings(void * Osiris, MappingInfo ** Mappings, uint32_t * MappingCount);
 		bool CallWrapper(std::function<bool(uint32_t, OsiArgumentDesc *)> const & next, uint32_t handle, OsiArgumentDesc * params);
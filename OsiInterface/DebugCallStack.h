@@ -0,0 +1,111 @@
+#pragma once
+
+#if !defined(OSI_NO_DEBUGGER)
+
+#include <cstdint>
+
+namespace dse
+{
+	class Node;
+	struct Goal;
+	struct TupleLL;
+	struct TuplePtrLL;
+
+	enum class BreakpointReason
+	{
+		NodeIsValid = 0,
+		NodePushDownTuple = 1,
+		NodeInsertTuple = 2,
+		NodeDeleteTuple = 3,
+		NodePushDownTupleDelete = 4,
+		RuleActionCall = 5,
+		GoalInitCall = 6,
+		GoalExitCall = 7
+	};
+
+	struct CallStackFrame
+	{
+		BreakpointReason frameType;
+		Node * node;
+		Goal * goal;
+		uint32_t actionIndex;
+		TupleLL * tupleLL;
+		TuplePtrLL * tuplePtrLL;
+	};
+
+	// Preallocated call stack of the debugger, so node hooks never allocate.
+	// Frames beyond MaxDepth are only counted; breakpoints can't trigger while the stack is overflowed.
+	class DebugCallStack
+	{
+	public:
+		static constexpr uint32_t MaxDepth = 1024;
+
+		inline void Push(CallStackFrame const & frame)
+		{
+			if (depth_ < MaxDepth) {
+				frames_[depth_] = frame;
+			}
+
+			depth_++;
+		}
+
+		inline void Pop()
+		{
+			depth_--;
+		}
+
+		inline void Clear()
+		{
+			depth_ = 0;
+		}
+
+		// Logical stack depth, including frames that didn't fit in the stack
+		inline uint32_t Depth() const
+		{
+			return depth_;
+		}
+
+		inline bool Empty() const
+		{
+			return depth_ == 0;
+		}
+
+		inline bool Overflowed() const
+		{
+			return depth_ > MaxDepth;
+		}
+
+		// Number of frames that are stored in the stack
+		inline uint32_t NumFrames() const
+		{
+			return (depth_ < MaxDepth) ? depth_ : MaxDepth;
+		}
+
+		inline CallStackFrame const & operator [] (uint32_t index) const
+		{
+			return frames_[index];
+		}
+
+		// Topmost stored frame; only valid if the stack is not empty or overflowed
+		inline CallStackFrame const & Top() const
+		{
+			return frames_[depth_ - 1];
+		}
+
+		inline CallStackFrame const * begin() const
+		{
+			return frames_;
+		}
+
+		inline CallStackFrame const * end() const
+		{
+			return frames_ + NumFrames();
+		}
+
+	private:
+		CallStackFrame frames_[MaxDepth];
+		uint32_t depth_{ 0 };
+	};
+}
+
+#endif
@@ -13,9 +13,58 @@
 
 namespace dse
 {
-	DebugInterface::DebugInterface(uint16_t port)
-		: port_(port)
+	SocketTransport::SocketTransport(SOCKET socket)
+		: socket_(socket)
+	{}
+
+	SocketTransport::~SocketTransport()
+	{
+		Close();
+	}
+
+	bool SocketTransport::Write(uint8_t const * buf, uint32_t length)
+	{
+		while (length > 0) {
+			int sent = send(socket_, (char const *)buf, (int)length, 0);
+			if (sent <= 0) {
+				ERR("Socket send failed: %d, error %d", sent, WSAGetLastError());
+				return false;
+			}
+
+			buf += sent;
+			length -= sent;
+		}
+
+		return true;
+	}
+
+	int SocketTransport::Read(uint8_t * buf, uint32_t length)
+	{
+		int len = recv(socket_, (char *)buf, (int)length, 0);
+		if (len < 0) {
+			ERR("Socket recv failed: %d, error %d", len, WSAGetLastError());
+		}
+
+		return len;
+	}
+
+	void SocketTransport::Close()
+	{
+		auto socket = socket_.exchange(INVALID_SOCKET);
+		if (socket != INVALID_SOCKET) {
+			closesocket(socket);
+		}
+	}
+
+
+	DebugInterface::DebugInterface(uint16_t port, DebugBatchConfig const & batchConfig)
+		: port_(port),
+		sendQueue_(DebugSendQueue::DefaultCapacity, batchConfig)
 	{
+		sendQueue_.SetErrorHandler([](char const * message) {
+			ERR("%s", message);
+		});
+
 		WSADATA wsaData;
 		WSAStartup(MAKEWORD(2, 2), &wsaData);
 
@@ -56,53 +105,22 @@ namespace dse
 
 	bool DebugInterface::IsConnected() const
 	{
-		return clientSocket_ != 0;
+		return connected_;
 	}
 
-	void DebugInterface::Send(BackendToDebugger const & msg)
+	void DebugInterface::Send(BackendToDebugger const & msg, DebugMessagePriority priority)
 	{
-		if (clientSocket_ == 0) {
+		if (!connected_) {
 			DEBUG("DebugInterface::Send(): Not connected to debugger frontend");
 			return;
 		}
 
-		uint32_t size = (uint32_t)msg.ByteSizeLong();
-		uint32_t packetSize = size + 4;
-		Send((uint8_t *)&packetSize, 4);
-
-		if (size < 0x100) {
-			uint8_t buf[0x100];
-			if (!msg.SerializeToArray(buf, size)) {
-				Fail("Unable to serialize message");
-			}
-
-			Send(buf, size);
-		}
-		else
-		{
-			uint8_t * buf = new uint8_t[size];
-			if (!msg.SerializeToArray(buf, size)) {
-				Fail("Unable to serialize message");
-			}
-
-			Send(buf, size);
-			delete[] buf;
-		}
+		sendQueue_.Enqueue(msg, priority);
 	}
 
-	void DebugInterface::Send(uint8_t * buf, uint32_t length)
+	bool DebugInterface::EnableBatching()
 	{
-		while (length > 0) {
-			int sent = send(clientSocket_, (char *)buf, (int)length, 0);
-			if (sent <= 0) {
-				ERR("Socket send failed: %d, error %d", sent, WSAGetLastError());
-				Disconnect();
-				return;
-			}
-
-			buf += sent;
-			length -= sent;
-		}
+		return sendQueue_.EnableBatching();
 	}
 
 	bool DebugInterface::ProcessMessage(uint8_t * buf, uint32_t length)
@@ -122,21 +140,26 @@ namespace dse
 	{
 		if (!IsConnected()) return;
 
-		closesocket(clientSocket_);
-		clientSocket_ = 0;
+		connected_ = false;
+		// Flush messages that were queued before the disconnect (eg. the version reply to an unsupported frontend)
+		sendQueue_.Stop();
+		client_->Close();
+
+		auto stats = sendQueue_.GetStats();
+		DEBUG("Debugger connection closed; sent %lld messages (%lld bytes, %lld batches), dropped %lld, %lld send stalls, peak queue depth %d",
+			stats.FramesSent, stats.BytesSent, stats.BatchesSent, stats.FramesDropped, stats.ProducerStalls, (int)stats.PeakDepth);
 
 		if (disconnectHandler_) {
 			disconnectHandler_();
 		}
 	}
 
-	void DebugInterface::MessageLoop(SOCKET sock)
+	void DebugInterface::MessageLoop()
 	{
 		receivePos_ = 0;
 		for (;;) {
-			int len = recv(sock, (char *)&receiveBuf_[receivePos_], sizeof(receiveBuf_) - receivePos_, 0);
-			if (len < 0) {
-				ERR("Socket recv failed: %d, error %d", len, WSAGetLastError());
+			int len = client_->Read(&receiveBuf_[receivePos_], sizeof(receiveBuf_) - receivePos_);
+			if (len <= 0) {
 				return;
 			}
 
@@ -170,13 +193,16 @@ namespace dse
 		for (;;) {
 			sockaddr_in addr;
 			int addrlen = sizeof(addr);
-			clientSocket_ = accept(socket_, (sockaddr *)&addr, &addrlen);
+			auto clientSocket = accept(socket_, (sockaddr *)&addr, &addrlen);
 			DEBUG("Accepted debug connection.");
+			client_ = std::make_unique<SocketTransport>(clientSocket);
+			sendQueue_.Start(client_.get());
+			connected_ = true;
 			if (connectHandler_) {
 				connectHandler_();
 			}
 
-			MessageLoop(clientSocket_);
+			MessageLoop();
 			Disconnect();
 		}
 	}
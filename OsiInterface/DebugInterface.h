@@ -3,15 +3,31 @@
 #if !defined(OSI_NO_DEBUGGER)
 
 #include <cstdint>
+#include <atomic>
 #include <WinSock2.h>
 #include "osidebug.pb.h"
+#include "DebugSendQueue.h"
 
 namespace dse
 {
+	class SocketTransport : public DebugTransport
+	{
+	public:
+		SocketTransport(SOCKET socket);
+		~SocketTransport() override;
+
+		bool Write(uint8_t const * buf, uint32_t length) override;
+		int Read(uint8_t * buf, uint32_t length) override;
+		void Close() override;
+
+	private:
+		std::atomic<SOCKET> socket_;
+	};
+
 	class DebugInterface
 	{
 	public:
-		DebugInterface(uint16_t port);
+		DebugInterface(uint16_t port, DebugBatchConfig const & batchConfig);
 		~DebugInterface();
 
 		void SetMessageHandler(
@@ -20,18 +36,27 @@ namespace dse
 			std::function<void()> disconnectHandler
 		);
 		bool IsConnected() const;
-		void Send(BackendToDebugger const & msg);
+		// Queues the message for sending; the socket write happens on the send queue writer thread
+		void Send(BackendToDebugger const & msg, DebugMessagePriority priority = DebugMessagePriority::Normal);
 		void Run();
 		void Disconnect();
+		// Called after the frontend announced that it can decode batched messages
+		bool EnableBatching();
+
+		inline DebugSendQueue::Stats GetSendStats()
+		{
+			return sendQueue_.GetStats();
+		}
 
 	private:
-		void Send(uint8_t * buf, uint32_t length);
 		bool ProcessMessage(uint8_t * buf, uint32_t length);
-		void MessageLoop(SOCKET sock);
+		void MessageLoop();
 
 		uint16_t port_;
 		SOCKET socket_;
-		SOCKET clientSocket_{ 0 };
+		std::unique_ptr<DebugTransport> client_;
+		std::atomic<bool> connected_{ false };
+		DebugSendQueue sendQueue_;
 		uint8_t receiveBuf_[0x10000];
 		uint32_t receivePos_;
 		std::function<bool (DebuggerToBackend const *)> messageHandler_;
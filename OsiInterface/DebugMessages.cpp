@@ -139,7 +139,7 @@ namespace dse
 		}
 	}
 
-	void MakeMsgCallStack(BkBreakpointTriggered & msg, std::vector<CallStackFrame> const & callStack)
+	void MakeMsgCallStack(BkBreakpointTriggered & msg, DebugCallStack const & callStack)
 	{
 		for (auto const & frame : callStack) {
 			auto msgFrame = msg.add_call_stack();
@@ -163,10 +163,10 @@ namespace dse
 		}
 	}
 
-	void DebugMessageHandler::SendBreakpointTriggered(std::vector<CallStackFrame> const & callStack,
+	void DebugMessageHandler::SendBreakpointTriggered(DebugCallStack const & callStack,
 		QueryResultInfo const * results)
 	{
-		auto const & lastFrame = *callStack.rbegin();
+		auto const & lastFrame = callStack.Top();
 		BackendToDebugger msg;
 		auto trigger = msg.mutable_breakpointtriggered();
 		MakeMsgCallStack(*trigger, callStack);
@@ -249,70 +249,92 @@ namespace dse
 		}
 	}
 
-	void DebugMessageHandler::SendSyncStory(Goal * goal)
+	void DebugMessageHandler::BeginSyncStory()
 	{
-		BackendToDebugger msg;
-		auto sync = msg.mutable_syncstorydata();
+		syncMsg_.Clear();
+		syncChunkBytes_ = 0;
+		syncChunkIndex_ = 0;
+	}
+
+	void DebugMessageHandler::SyncStoryGoal(Goal * goal)
+	{
+		auto sync = syncMsg_.mutable_syncstorydata();
 		auto goalInfo = sync->add_goal();
 		goalInfo->set_id(goal->Id);
 		goalInfo->set_name(goal->Name);
 		AddActionInfo(goal->InitCalls, [goalInfo]() -> MsgActionInfo * { return goalInfo->add_initactions(); });
 		AddActionInfo(goal->ExitCalls, [goalInfo]() -> MsgActionInfo * { return goalInfo->add_exitactions(); });
-		Send(msg);
-		DEBUG(" <-- BkSyncStoryData(Goal #%d)", goal->Id);
+		AddedSyncStoryItem(goalInfo->ByteSizeLong());
 	}
 
-	void DebugMessageHandler::SendSyncStory(Database ** databases, uint32_t count)
+	void DebugMessageHandler::SyncStoryDatabase(Database * database)
 	{
-		BackendToDebugger msg;
-		auto sync = msg.mutable_syncstorydata();
-		for (uint32_t i = 0; i < count; i++) {
-			auto * db = databases[i];
-			auto dbInfo = sync->add_database();
-			dbInfo->set_id(db->DatabaseId);
-			auto numParams = db->NumParams;
-			auto const & paramTypes = db->ParamTypes;
-			for (auto arg = 0; arg < numParams; arg++) {
-				dbInfo->add_argumenttype(paramTypes[arg]);
-			}
+		auto sync = syncMsg_.mutable_syncstorydata();
+		auto dbInfo = sync->add_database();
+		dbInfo->set_id(database->DatabaseId);
+		auto numParams = database->NumParams;
+		auto const & paramTypes = database->ParamTypes;
+		for (auto arg = 0; arg < numParams; arg++) {
+			dbInfo->add_argumenttype(paramTypes[arg]);
 		}
 
-		Send(msg);
-		DEBUG(" <-- BkSyncStoryData(%d databases)", count);
+		AddedSyncStoryItem(dbInfo->ByteSizeLong());
 	}
 
-	void DebugMessageHandler::SendSyncStory(Node ** nodes, uint32_t count)
+	void DebugMessageHandler::SyncStoryNode(Node * node)
 	{
-		BackendToDebugger msg;
-		auto sync = msg.mutable_syncstorydata();
-		for (uint32_t i = 0; i < count; i++) {
-			auto * node = nodes[i];
-			auto nodeInfo = sync->add_node();
-			nodeInfo->set_id(node->Id);
-			auto type = gNodeVMTWrappers->GetType(node);
-			nodeInfo->set_type((uint32_t)type);
-			if (node->Function != nullptr) {
-				nodeInfo->set_name(node->Function->Signature->Name);
-			}
-			
-			if (type == NodeType::Rule) {
-				auto ruleInfo = sync->add_rule();
-				ruleInfo->set_node_id(node->Id);
-				RuleNode * rule = static_cast<RuleNode *>(node);
-				AddActionInfo(rule->Calls, [ruleInfo]() -> MsgActionInfo * { return ruleInfo->add_actions(); });
-			}
+		auto sync = syncMsg_.mutable_syncstorydata();
+		auto nodeInfo = sync->add_node();
+		nodeInfo->set_id(node->Id);
+		auto type = gNodeVMTWrappers->GetType(node);
+		nodeInfo->set_type((uint32_t)type);
+		if (node->Function != nullptr) {
+			nodeInfo->set_name(node->Function->Signature->Name);
 		}
 
-		Send(msg);
-		DEBUG(" <-- BkSyncStoryData(%d nodes)", count);
+		auto itemBytes = nodeInfo->ByteSizeLong();
+		if (type == NodeType::Rule) {
+			auto ruleInfo = sync->add_rule();
+			ruleInfo->set_node_id(node->Id);
+			RuleNode * rule = static_cast<RuleNode *>(node);
+			AddActionInfo(rule->Calls, [ruleInfo]() -> MsgActionInfo * { return ruleInfo->add_actions(); });
+			itemBytes += ruleInfo->ByteSizeLong();
+		}
+
+		AddedSyncStoryItem(itemBytes);
+	}
+
+	void DebugMessageHandler::AddedSyncStoryItem(std::size_t itemBytes)
+	{
+		// Approximate size; doesn't include field tags and length prefixes
+		syncChunkBytes_ += itemBytes;
+		if (syncChunkBytes_ >= SyncStoryChunkSize) {
+			FlushSyncStoryChunk();
+		}
+	}
+
+	void DebugMessageHandler::FlushSyncStoryChunk()
+	{
+		if (!syncMsg_.has_syncstorydata()) return;
+
+		auto sync = syncMsg_.mutable_syncstorydata();
+		sync->set_chunk_index(syncChunkIndex_++);
+		DEBUG(" <-- BkSyncStoryData(#%d: %d goals, %d databases, %d nodes)", sync->chunk_index(),
+			sync->goal_size(), sync->database_size(), sync->node_size());
+		Send(syncMsg_);
+		syncMsg_.Clear();
+		syncChunkBytes_ = 0;
 	}
 
 	void DebugMessageHandler::SendSyncStoryFinished()
 	{
+		FlushSyncStoryChunk();
+
 		BackendToDebugger msg;
 		auto syncFinished = msg.mutable_syncstoryfinished();
+		syncFinished->set_num_chunks(syncChunkIndex_);
 		Send(msg);
-		DEBUG(" <-- BkSyncStoryFinished()");
+		DEBUG(" <-- BkSyncStoryFinished(%d chunks)", syncChunkIndex_);
 	}
 
 	void DebugMessageHandler::SendDebugOutput(char const * message)
@@ -320,7 +342,8 @@ namespace dse
 		BackendToDebugger msg;
 		auto debugMsg = msg.mutable_debugoutput();
 		debugMsg->set_message(message);
-		Send(msg);
+		// Debug output may be discarded if the frontend can't keep up
+		Send(msg, DebugMessagePriority::Trace);
 		DEBUG(" <-- BkDebugOutput(): \"%s\"", message);
 	}
 
@@ -331,8 +354,11 @@ namespace dse
 
 	void DebugMessageHandler::HandleIdentify(uint32_t seq, DbgIdentifyRequest const & req)
 	{
-		DEBUG(" --> DbgIdentifyRequest(Version %d)", req.protocol_version());
-		SendVersionInfo(seq);
+		DEBUG(" --> DbgIdentifyRequest(Version %d, batching %d)", req.protocol_version(), req.supports_batching() ? 1 : 0);
+		bool batching = req.protocol_version() == ProtocolVersion
+			&& req.supports_batching()
+			&& intf_.EnableBatching();
+		SendVersionInfo(seq, batching);
 
 		if (req.protocol_version() != ProtocolVersion) {
 			WARN("DebugMessageHandler::HandleIdentify(): Client sent unsupported protocol version; got %d, we only support %d", 
@@ -373,15 +399,10 @@ namespace dse
 
 			debugger_->Breakpoints().BeginUpdatingNodeBreakpoints();
 			for (auto const & bp : req.breakpoint()) {
-				DEBUG("AddBreakpoint(node %d, goal %d, action %d, flags %d)",
-					bp.node_id(), bp.goal_id(), bp.action_index(), bp.breakpoint_mask());
-				rc = debugger_->Breakpoints().AddBreakpoint(
-					bp.node_id(),
-					bp.goal_id(), 
-					bp.is_init_action(),
-					bp.action_index(),
-					(BreakpointType)bp.breakpoint_mask()
-				);
+				DEBUG("AddBreakpoint(node %d, goal %d, action %d, flags %d, %d conditions, hit count %d%s)",
+					bp.node_id(), bp.goal_id(), bp.action_index(), bp.breakpoint_mask(),
+					bp.condition_size(), bp.hit_count(), bp.log_only() ? ", log only" : "");
+				rc = debugger_->Breakpoints().AddBreakpoint(bp);
 
 				if (rc != ResultCode::Success) {
 					break;
@@ -396,7 +417,8 @@ namespace dse
 
 	void DebugMessageHandler::HandleGetDatabaseContents(uint32_t seq, DbgGetDatabaseContents const & req)
 	{
-		DEBUG(" --> DbgGetDatabaseContents(%d)", req.database_id());
+		DEBUG(" --> DbgGetDatabaseContents(%d, offset %d, limit %d, %d filters)", req.database_id(),
+			req.offset(), req.limit(), req.filter_size());
 
 		ResultCode rc;
 		if (!debugger_) {
@@ -405,7 +427,7 @@ namespace dse
 		}
 		else
 		{
-			rc = debugger_->GetDatabaseContents(req.database_id());
+			rc = debugger_->GetDatabaseContents(req);
 		}
 
 		SendResult(seq, rc);
@@ -430,10 +452,12 @@ namespace dse
 
 	void DebugMessageHandler::HandleSyncStory(uint32_t seq, DbgSyncStory const & req)
 	{
-		DEBUG(" --> DbgSyncStory()");
+		DEBUG(" --> DbgSyncStory(%d goals)", req.goal_id_size());
 
+		BeginSyncStory();
 		if (debugger_) {
-			debugger_->SyncStory();
+			std::vector<uint32_t> goalIds(req.goal_id().begin(), req.goal_id().end());
+			debugger_->SyncStory(goalIds);
 		} else {
 			WARN("SyncStory: Not attached to story debugger!");
 		}
@@ -446,12 +470,7 @@ namespace dse
 		DEBUG(" --> DbgEvaluate(%d, %d)", req.type(), req.node_id());
 
 		if (debugger_) {
-			bool querySucceeded = false;
-			auto process = [this, seq] (ResultCode rc, bool querySucceeded) {
-				SendEvaluateFinished(seq, rc, querySucceeded);
-			};
-
-			debugger_->Evaluate(seq, (EvalType)req.type(), req.node_id(), req.params(), process);
+			debugger_->Evaluate(seq, (EvalType)req.type(), req.node_id(), req.params());
 		} else {
 			WARN("Evaluate: Not attached to story debugger!");
 		}
@@ -523,11 +542,11 @@ namespace dse
 		}
 	}
 
-	void DebugMessageHandler::Send(BackendToDebugger & msg)
+	void DebugMessageHandler::Send(BackendToDebugger & msg, DebugMessagePriority priority)
 	{
 		if (intf_.IsConnected()) {
 			msg.set_seq_no(outboundSeq_++);
-			intf_.Send(msg);
+			intf_.Send(msg, priority);
 		}
 	}
 
@@ -541,11 +560,12 @@ namespace dse
 		DEBUG(" <-- BkResult(%d)", code);
 	}
 
-	void DebugMessageHandler::SendVersionInfo(uint32_t seq)
+	void DebugMessageHandler::SendVersionInfo(uint32_t seq, bool batchingEnabled)
 	{
 		BackendToDebugger msg;
 		auto version = msg.mutable_versioninfo();
 		version->set_protocol_version(ProtocolVersion);
+		version->set_batching_enabled(batchingEnabled);
 		if (debugger_ != nullptr)
 		{
 			version->set_story_loaded(true);
@@ -570,26 +590,30 @@ namespace dse
 		DEBUG(" <-- BkBeginDatabaseContents()");
 	}
 
-	void DebugMessageHandler::SendDatabaseRow(uint32_t databaseId, TupleVec * row)
+	void DebugMessageHandler::SendDatabaseRows(uint32_t databaseId, TupleVec ** rows, uint32_t numRows)
 	{
 		BackendToDebugger msg;
 		auto rowMsg = msg.mutable_databaserow();
 		rowMsg->set_database_id(databaseId);
 
-		auto msgRow = rowMsg->add_row();
-		MakeMsgTuple(*msgRow, *row);
+		for (uint32_t i = 0; i < numRows; i++) {
+			auto msgRow = rowMsg->add_row();
+			MakeMsgTuple(*msgRow, *rows[i]);
+		}
 
 		Send(msg);
-		DEBUG(" <-- BkDatabaseRow()");
+		DEBUG(" <-- BkDatabaseRow(%d rows)", numRows);
 	}
 
-	void DebugMessageHandler::SendEndDatabaseContents(uint32_t databaseId)
+	void DebugMessageHandler::SendEndDatabaseContents(uint32_t databaseId, uint32_t matchingRows, uint32_t rowsSent)
 	{
 		BackendToDebugger msg;
 		auto endMsg = msg.mutable_enddatabasecontents();
 		endMsg->set_database_id(databaseId);
+		endMsg->set_matching_rows(matchingRows);
+		endMsg->set_rows_sent(rowsSent);
 		Send(msg);
-		DEBUG(" <-- BkEndDatabaseContents()");
+		DEBUG(" <-- BkEndDatabaseContents(%d matching, %d sent)", matchingRows, rowsSent);
 	}
 
 	void DebugMessageHandler::SendEvaluateRow(uint32_t seq, VirtTupleLL & row)
@@ -614,6 +638,33 @@ namespace dse
 		Send(msg);
 		DEBUG(" <-- BkEvaluateFinished()");
 	}
+
+	void DebugMessageHandler::SendTracepointHit(CallStackFrame const & frame, std::string const & message, uint32_t hitCount)
+	{
+		BackendToDebugger msg;
+		auto hit = msg.mutable_tracepointhit();
+		if (frame.node != nullptr) {
+			hit->set_node_id(frame.node->Id);
+		}
+
+		if (frame.goal != nullptr) {
+			hit->set_goal_id(frame.goal->Id);
+		}
+
+		hit->set_action_index(frame.actionIndex);
+		hit->set_message(message);
+		hit->set_hit_count(hitCount);
+
+		auto tuple = hit->mutable_tuple();
+		if (frame.tupleLL != nullptr) {
+			MakeMsgTuple(*tuple, *frame.tupleLL);
+		} else if (frame.tuplePtrLL != nullptr) {
+			MakeMsgTuple(*tuple, *frame.tuplePtrLL);
+		}
+
+		// Tracepoints may fire at a high rate; drop them if the frontend can't keep up
+		Send(msg, DebugMessagePriority::Trace);
+	}
 }
 
 #endif
@@ -6,6 +6,7 @@
 #include "osidebug.pb.h"
 #include <GameDefinitions/Osiris.h>
 #include "DebugInterface.h"
+#include "DebugCallStack.h"
 
 namespace dse
 {
@@ -16,18 +17,6 @@ namespace dse
 		GameExit = 2
 	};
 
-	enum class BreakpointReason
-	{
-		NodeIsValid = 0,
-		NodePushDownTuple = 1,
-		NodeInsertTuple = 2,
-		NodeDeleteTuple = 3,
-		NodePushDownTupleDelete = 4,
-		RuleActionCall = 5,
-		GoalInitCall = 6,
-		GoalExitCall = 7
-	};
-
 	enum class ResultCode
 	{
 		Success = 0,
@@ -47,7 +36,8 @@ namespace dse
 		EvalEngineNotReady = 14,
 		InvalidParamTupleArity = 15,
 		InvalidParamType = 16,
-		MissingRequiredParam = 17
+		MissingRequiredParam = 17,
+		TooManyPendingRequests = 18
 	};
 
 	enum class EvalType
@@ -58,16 +48,6 @@ namespace dse
 		Delete = 3
 	};
 
-	struct CallStackFrame
-	{
-		BreakpointReason frameType;
-		Node * node;
-		Goal * goal;
-		uint32_t actionIndex;
-		TupleLL * tupleLL;
-		TuplePtrLL * tuplePtrLL;
-	};
-
 	struct QueryResultInfo
 	{
 		// Node ID of last query
@@ -93,21 +73,23 @@ namespace dse
 		}
 
 		void SetDebugger(Debugger * debugger);
-		void SendBreakpointTriggered(std::vector<CallStackFrame> const & callStack,
+		void SendBreakpointTriggered(DebugCallStack const & callStack,
 			QueryResultInfo const * results = nullptr);
 		void SendGlobalBreakpointTriggered(GlobalBreakpointReason reason);
 		void SendStoryLoaded();
 		void SendDebugSessionEnded();
-		void SendSyncStory(Goal * goal);
-		void SendSyncStory(Database ** databases, uint32_t count);
-		void SendSyncStory(Node ** nodes, uint32_t count);
+		void BeginSyncStory();
+		void SyncStoryGoal(Goal * goal);
+		void SyncStoryDatabase(Database * database);
+		void SyncStoryNode(Node * node);
 		void SendSyncStoryFinished();
 		void SendDebugOutput(char const * message);
 		void SendBeginDatabaseContents(uint32_t databaseId);
-		void SendDatabaseRow(uint32_t databaseId, TupleVec * row);
-		void SendEndDatabaseContents(uint32_t databaseId);
+		void SendDatabaseRows(uint32_t databaseId, TupleVec ** rows, uint32_t numRows);
+		void SendEndDatabaseContents(uint32_t databaseId, uint32_t matchingRows, uint32_t rowsSent);
 		void SendEvaluateRow(uint32_t seq, VirtTupleLL & row);
 		void SendEvaluateFinished(uint32_t seq, ResultCode rc, bool querySucceeded);
+		void SendTracepointHit(CallStackFrame const & frame, std::string const & message, uint32_t hitCount);
 
 	private:
 		DebugInterface & intf_;
@@ -115,6 +97,16 @@ namespace dse
 		uint32_t inboundSeq_{ 1 };
 		uint32_t outboundSeq_{ 1 };
 
+		// Max. size of a story sync message; items are flushed when a chunk reaches this size
+		static constexpr std::size_t SyncStoryChunkSize = 0x10000;
+		// Story sync chunk that is being built
+		BackendToDebugger syncMsg_;
+		std::size_t syncChunkBytes_{ 0 };
+		uint32_t syncChunkIndex_{ 0 };
+
+		void AddedSyncStoryItem(std::size_t itemBytes);
+		void FlushSyncStoryChunk();
+
 		bool HandleMessage(DebuggerToBackend const * msg);
 		void HandleConnect();
 		void HandleDisconnect();
@@ -127,8 +119,8 @@ namespace dse
 		void HandleSyncStory(uint32_t seq, DbgSyncStory const & req);
 		void HandleEvaluate(uint32_t seq, DbgEvaluate const & req);
 
-		void Send(BackendToDebugger & msg);
-		void SendVersionInfo(uint32_t seq);
+		void Send(BackendToDebugger & msg, DebugMessagePriority priority = DebugMessagePriority::Normal);
+		void SendVersionInfo(uint32_t seq, bool batchingEnabled);
 		void SendResult(uint32_t seq, ResultCode code);
 	};
 }
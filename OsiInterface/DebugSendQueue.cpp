@@ -0,0 +1,318 @@
+#include "DebugSendQueue.h"
+
+#if !defined(OSI_NO_DEBUGGER)
+
+#include <cstdio>
+#include <cstring>
+
+namespace dse
+{
+	// Wire format of the BackendToDebugger.batch envelope (see BkMessageBatch in osidebug.proto).
+	// Queued frames are already serialized, so the envelope is assembled without re-encoding them.
+	static constexpr uint32_t BatchFieldTag = (19 << 3) | 2; // BackendToDebugger.batch, length-delimited
+	static constexpr uint32_t BatchMessageTag = (1 << 3) | 2; // BkMessageBatch.messages, length-delimited
+
+	static uint32_t VarintSize(uint32_t value)
+	{
+		uint32_t size = 1;
+		while (value >= 0x80) {
+			value >>= 7;
+			size++;
+		}
+
+		return size;
+	}
+
+	static void AppendVarint(std::vector<uint8_t> & buf, uint32_t value)
+	{
+		while (value >= 0x80) {
+			buf.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+
+		buf.push_back((uint8_t)value);
+	}
+
+	DebugSendQueue::DebugSendQueue(std::size_t capacity, DebugBatchConfig const & batchConfig)
+		: batchConfig_(batchConfig)
+	{
+		// Round up to the next power of two, so slot indices can be masked instead of divided
+		std::size_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+
+		slots_.resize(size);
+		writeFrames_.resize(size);
+		mask_ = size - 1;
+	}
+
+	DebugSendQueue::~DebugSendQueue()
+	{
+		Stop();
+	}
+
+	void DebugSendQueue::Start(DebugTransport * transport)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		// Producers that reserved a slot in the previous session must not publish into this one
+		generation_++;
+		tail_ = 0;
+		count_ = 0;
+		for (auto & slot : slots_) {
+			slot.Ready = false;
+		}
+
+		stats_ = Stats{};
+		transport_ = transport;
+		running_ = true;
+		batching_ = false;
+		writerThread_ = std::make_unique<std::thread>(std::bind(&DebugSendQueue::WriterThread, this));
+	}
+
+	void DebugSendQueue::Stop()
+	{
+		if (!writerThread_) return;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			running_ = false;
+		}
+
+		writerCv_.notify_all();
+		producerCv_.notify_all();
+		writerThread_->join();
+		writerThread_.reset();
+		transport_ = nullptr;
+	}
+
+	bool DebugSendQueue::EnableBatching()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		batching_ = (batchConfig_.MaxBytes > 0);
+		return batching_;
+	}
+
+	void DebugSendQueue::SetErrorHandler(DebugSendQueueErrorHandler handler)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		errorHandler_ = std::move(handler);
+	}
+
+	void DebugSendQueue::ReportError(char const * message)
+	{
+		DebugSendQueueErrorHandler handler;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			handler = errorHandler_;
+		}
+
+		if (handler) {
+			handler(message);
+		}
+	}
+
+	bool DebugSendQueue::Enqueue(uint32_t size, DebugFrameSerializer const & serialize, DebugMessagePriority priority)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (!running_) return false;
+
+		if (count_ == slots_.size()) {
+			if (priority == DebugMessagePriority::Trace) {
+				stats_.FramesDropped++;
+				return false;
+			}
+
+			stats_.ProducerStalls++;
+			producerCv_.wait(lock, [this]() { return !running_ || count_ < slots_.size(); });
+			if (!running_) return false;
+		}
+
+		// Reserve the next slot; the frame is serialized outside of the lock
+		auto index = (tail_ + count_) & mask_;
+		count_++;
+		if (count_ > stats_.PeakDepth) {
+			stats_.PeakDepth = count_;
+		}
+
+		auto generation = generation_;
+		std::vector<uint8_t> frame;
+		frame.swap(slots_[index].Frame);
+		lock.unlock();
+
+		uint32_t packetSize = size + 4;
+		frame.resize(packetSize);
+		memcpy(frame.data(), &packetSize, 4);
+		bool serialized = serialize(frame.data() + 4, size);
+		if (!serialized) {
+			// The slot is already reserved, so it is published empty to keep the frames behind it flowing
+			frame.clear();
+			ReportError("DebugSendQueue::Enqueue(): Unable to serialize message");
+		}
+
+		lock.lock();
+		if (generation != generation_) {
+			return false;
+		}
+
+		auto & slot = slots_[index];
+		slot.Frame.swap(frame);
+		slot.Priority = priority;
+		slot.Ready = true;
+		lock.unlock();
+
+		writerCv_.notify_one();
+		return serialized;
+	}
+
+	DebugSendQueue::Stats DebugSendQueue::GetStats()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		return stats_;
+	}
+
+	std::size_t DebugSendQueue::PendingBatch(bool & flush) const
+	{
+		// Frames can only be sent in order, so the batch ends at the first frame that is still being serialized
+		std::size_t numFrames = 0, batchBytes = 0;
+		flush = (count_ == slots_.size());
+		while (numFrames < count_) {
+			auto const & slot = slots_[(tail_ + numFrames) & mask_];
+			if (!slot.Ready) break;
+
+			if (numFrames > 0 && batchBytes + slot.Frame.size() > batchConfig_.MaxBytes) {
+				flush = true;
+				break;
+			}
+
+			batchBytes += slot.Frame.size();
+			// Only trace messages are held back for batching
+			if (slot.Priority != DebugMessagePriority::Trace) {
+				flush = true;
+			}
+
+			numFrames++;
+		}
+
+		return numFrames;
+	}
+
+	void DebugSendQueue::BuildBatchFrame(std::size_t numFrames)
+	{
+		uint32_t batchSize = 0;
+		for (std::size_t i = 0; i < numFrames; i++) {
+			if (writeFrames_[i].empty()) continue;
+			auto messageSize = (uint32_t)writeFrames_[i].size() - 4;
+			batchSize += VarintSize(BatchMessageTag) + VarintSize(messageSize) + messageSize;
+		}
+
+		batchFrame_.resize(4);
+		AppendVarint(batchFrame_, BatchFieldTag);
+		AppendVarint(batchFrame_, batchSize);
+		for (std::size_t i = 0; i < numFrames; i++) {
+			auto const & frame = writeFrames_[i];
+			if (frame.empty()) continue;
+			AppendVarint(batchFrame_, BatchMessageTag);
+			AppendVarint(batchFrame_, (uint32_t)frame.size() - 4);
+			batchFrame_.insert(batchFrame_.end(), frame.begin() + 4, frame.end());
+		}
+
+		uint32_t packetSize = (uint32_t)batchFrame_.size();
+		memcpy(batchFrame_.data(), &packetSize, 4);
+	}
+
+	void DebugSendQueue::WriterThread()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		for (;;) {
+			writerCv_.wait(lock, [this]() { return !running_ || (count_ > 0 && slots_[tail_].Ready); });
+			// Frames that were queued before Stop() are still sent
+			if (count_ == 0 || !slots_[tail_].Ready) {
+				break;
+			}
+
+			std::size_t numFrames = 1;
+			if (batching_) {
+				bool flush;
+				numFrames = PendingBatch(flush);
+				if (!flush && batchConfig_.FlushIntervalMs > 0) {
+					auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(batchConfig_.FlushIntervalMs);
+					writerCv_.wait_until(lock, deadline, [this, &flush]() {
+						PendingBatch(flush);
+						return !running_ || flush;
+					});
+					numFrames = PendingBatch(flush);
+				}
+			}
+
+			for (std::size_t i = 0; i < numFrames; i++) {
+				writeFrames_[i].swap(slots_[(tail_ + i) & mask_].Frame);
+			}
+			lock.unlock();
+
+			std::size_t numMessages = 0;
+			for (std::size_t i = 0; i < numFrames; i++) {
+				if (!writeFrames_[i].empty()) {
+					numMessages++;
+				}
+			}
+
+			bool written = true;
+			std::size_t bytesWritten = 0;
+			if (numMessages == 1) {
+				for (std::size_t i = 0; i < numFrames; i++) {
+					auto const & frame = writeFrames_[i];
+					if (!frame.empty()) {
+						written = transport_->Write(frame.data(), (uint32_t)frame.size());
+						bytesWritten = frame.size();
+					}
+				}
+			} else if (numMessages > 1) {
+				BuildBatchFrame(numFrames);
+				written = transport_->Write(batchFrame_.data(), (uint32_t)batchFrame_.size());
+				bytesWritten = batchFrame_.size();
+				if (batchFrame_.capacity() > MaxRetainedFrameSize) {
+					batchFrame_ = std::vector<uint8_t>();
+				}
+			}
+
+			lock.lock();
+			for (std::size_t i = 0; i < numFrames; i++) {
+				auto & frame = writeFrames_[i];
+				if (frame.capacity() > MaxRetainedFrameSize) {
+					frame = std::vector<uint8_t>();
+				}
+
+				auto & slot = slots_[tail_];
+				slot.Frame.swap(frame);
+				slot.Ready = false;
+				tail_ = (tail_ + 1) & mask_;
+			}
+
+			count_ -= numFrames;
+
+			if (written) {
+				stats_.FramesSent += numMessages;
+				stats_.BytesSent += bytesWritten;
+				if (numMessages > 1) {
+					stats_.BatchesSent++;
+				}
+				producerCv_.notify_all();
+			} else {
+				auto discarded = (int)count_;
+				running_ = false;
+				// Wakes the receiver thread, which takes care of the disconnect
+				transport_->Close();
+				producerCv_.notify_all();
+				lock.unlock();
+
+				char message[128];
+				snprintf(message, sizeof(message), "DebugSendQueue::WriterThread(): Write failed; discarding %d queued messages", discarded);
+				ReportError(message);
+				break;
+			}
+		}
+	}
+}
+
+#endif
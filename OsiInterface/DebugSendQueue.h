@@ -0,0 +1,128 @@
+#pragma once
+
+#if !defined(OSI_NO_DEBUGGER)
+
+#include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <google/protobuf/message_lite.h>
+#include "DebugTransport.h"
+
+namespace dse
+{
+	enum class DebugMessagePriority
+	{
+		// Producer waits for space in the queue
+		Normal,
+		// Message is discarded if the queue is full
+		Trace
+	};
+
+	struct DebugBatchConfig
+	{
+		// Max. size of a batch frame; 0 disables batching
+		uint32_t MaxBytes{ 0x10000 };
+		// Max. time a trace message is held back while waiting for more messages
+		uint32_t FlushIntervalMs{ 5 };
+	};
+
+	// Writes the message body into the frame buffer (which is exactly the requested size);
+	// returns false if the message could not be serialized
+	using DebugFrameSerializer = std::function<bool (uint8_t * buf, uint32_t size)>;
+	// Receives the errors of the send queue; called without the queue lock held
+	using DebugSendQueueErrorHandler = std::function<void (char const * message)>;
+
+	// Bounded multi-producer queue of serialized messages that are written to the
+	// transport by a dedicated writer thread, so callers (usually the Osiris server thread)
+	// don't block on socket writes.
+	// Frame buffers are owned by the queue slots and are reused across messages.
+	// When batching is enabled, consecutive frames are sent in a single BkMessageBatch
+	// envelope (one transport write per batch).
+	// The queue only depends on DebugTransport and the standard library, so it can be
+	// built and tested without the rest of the extender.
+	class DebugSendQueue
+	{
+	public:
+		static constexpr std::size_t DefaultCapacity = 256;
+
+		struct Stats
+		{
+			uint64_t FramesSent{ 0 };
+			uint64_t BytesSent{ 0 };
+			// Number of batch envelopes written (each containing 2 or more frames)
+			uint64_t BatchesSent{ 0 };
+			// Trace messages discarded because the queue was full
+			uint64_t FramesDropped{ 0 };
+			// Number of times a producer had to wait for the writer
+			uint64_t ProducerStalls{ 0 };
+			std::size_t PeakDepth{ 0 };
+		};
+
+		DebugSendQueue(std::size_t capacity = DefaultCapacity, DebugBatchConfig const & batchConfig = DebugBatchConfig{});
+		~DebugSendQueue();
+
+		void Start(DebugTransport * transport);
+		// Stops the writer thread; frames that are already queued are sent before returning
+		void Stop();
+		// Enables batching for the current session (i.e. until the next Start());
+		// returns false if batching was disabled in the configuration
+		bool EnableBatching();
+		void SetErrorHandler(DebugSendQueueErrorHandler handler);
+
+		bool Enqueue(uint32_t size, DebugFrameSerializer const & serialize, DebugMessagePriority priority);
+		Stats GetStats();
+
+		inline bool Enqueue(google::protobuf::MessageLite const & msg, DebugMessagePriority priority)
+		{
+			return Enqueue((uint32_t)msg.ByteSizeLong(), [&msg](uint8_t * buf, uint32_t size) {
+				return msg.SerializeToArray(buf, (int)size);
+			}, priority);
+		}
+
+	private:
+		// Frames larger than this are released after sending instead of being kept for reuse
+		static constexpr std::size_t MaxRetainedFrameSize = 0x100000;
+
+		struct Slot
+		{
+			std::vector<uint8_t> Frame;
+			DebugMessagePriority Priority{ DebugMessagePriority::Normal };
+			// Frame was fully serialized by the producer; frames that failed to serialize
+			// are published empty and are skipped by the writer
+			bool Ready{ false };
+		};
+
+		std::mutex mutex_;
+		std::condition_variable writerCv_;
+		std::condition_variable producerCv_;
+		std::vector<Slot> slots_;
+		std::size_t mask_;
+		std::size_t tail_{ 0 };
+		std::size_t count_{ 0 };
+		// Incremented on each Start(), invalidates slot reservations from the previous session
+		uint32_t generation_{ 0 };
+		bool running_{ false };
+		bool batching_{ false };
+		DebugBatchConfig batchConfig_;
+		Stats stats_;
+		DebugSendQueueErrorHandler errorHandler_;
+
+		DebugTransport * transport_{ nullptr };
+		std::unique_ptr<std::thread> writerThread_;
+		// Frames taken from the slots during a write; only accessed by the writer thread
+		std::vector<std::vector<uint8_t>> writeFrames_;
+		std::vector<uint8_t> batchFrame_;
+
+		void WriterThread();
+		std::size_t PendingBatch(bool & flush) const;
+		void BuildBatchFrame(std::size_t numFrames);
+		void ReportError(char const * message);
+	};
+}
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace dse
+{
+	// Stream connection to the debugger frontend.
+	// Implementations must allow Close() to be called from a thread other than the one
+	// that is blocked in Read() / Write(), and must make repeated Close() calls a no-op.
+	class DebugTransport
+	{
+	public:
+		virtual ~DebugTransport() {}
+
+		// Writes the whole buffer; returns false if the connection failed
+		virtual bool Write(uint8_t const * buf, uint32_t length) = 0;
+		// Reads at most length bytes; returns the number of bytes read, or <= 0 on failure
+		virtual int Read(uint8_t * buf, uint32_t length) = 0;
+		virtual void Close() = 0;
+	};
+}
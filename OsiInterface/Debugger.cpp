@@ -3,6 +3,8 @@
 #include "NodeHooks.h"
 #include "OsirisProxy.h"
 #include <sstream>
+#include <algorithm>
+#include <thread>
 
 #if !defined(OSI_NO_DEBUGGER)
 #undef DUMP_TRACEPOINTS
@@ -13,27 +15,94 @@ namespace dse
 		: globals_(globals)
 	{}
 
+	void RuleActionMap::Reset(std::size_t expectedMappings)
+	{
+		numMappings_ = 0;
+		ruleActionMappings_.clear();
+		Rehash(expectedMappings);
+	}
+
+	void RuleActionMap::Rehash(std::size_t expectedMappings)
+	{
+		// Keep the load factor below 50%
+		std::size_t capacity = 16;
+		unsigned shift = 60;
+		while (capacity < expectedMappings * 2) {
+			capacity <<= 1;
+			shift--;
+		}
+
+		if (capacity <= ruleActionMappings_.size()) return;
+
+		std::vector<RuleActionMapping> oldMappings(capacity, RuleActionMapping{ nullptr, nullptr, nullptr, false, 0 });
+		std::swap(oldMappings, ruleActionMappings_);
+		hashShift_ = shift;
+		numMappings_ = 0;
+
+		for (auto const & mapping : oldMappings) {
+			if (mapping.action != nullptr) {
+				Insert(mapping);
+			}
+		}
+	}
+
+	void RuleActionMap::Insert(RuleActionMapping const & mapping)
+	{
+		if ((numMappings_ + 1) * 2 > ruleActionMappings_.size()) {
+			Rehash(numMappings_ + 1);
+		}
+
+		auto mask = ruleActionMappings_.size() - 1;
+		auto slot = GetSlot(mapping.action);
+		while (ruleActionMappings_[slot].action != nullptr) {
+			if (ruleActionMappings_[slot].action == mapping.action) {
+				// Keep the first mapping, same as the previous unordered_map::insert() behavior
+				return;
+			}
+
+			slot = (slot + 1) & mask;
+		}
+
+		ruleActionMappings_[slot] = mapping;
+		numMappings_++;
+	}
+
 	void RuleActionMap::AddRuleActionMappings(Node * node, Goal * goal, bool isInit, RuleActionList * actions)
 	{
 		auto head = actions->Actions.Head;
 		auto current = head->Next;
 		uint32_t actionIndex = 0;
 		while (current != head) {
-			ruleActionMappings_.insert(std::pair<RuleActionNode *, RuleActionMapping>(
-				current->Item,
-				{ current->Item, node, goal, isInit, actionIndex }
-			));
+			Insert({ current->Item, node, goal, isInit, actionIndex });
 			current = current->Next;
 			actionIndex++;
 		}
 	}
 
-	void RuleActionMap::UpdateRuleActionMappings()
+	std::size_t RuleActionMap::CountRuleActions(uint32_t firstNode, uint32_t firstGoal)
 	{
-		ruleActionMappings_.clear();
+		std::size_t numActions = 0;
+		auto const & nodeDb = (*globals_.Nodes)->Db;
+		for (unsigned i = firstNode; i < nodeDb.Size; i++) {
+			auto node = nodeDb.Start[i];
+			if (gNodeVMTWrappers->GetType(node) == NodeType::Rule) {
+				numActions += static_cast<RuleNode *>(node)->Calls->Actions.Size;
+			}
+		}
+
+		auto const & goalDb = (*globals_.Goals);
+		for (unsigned i = firstGoal; i < goalDb->Count; i++) {
+			auto goal = *goalDb->Goals.Find(i + 1);
+			numActions += goal->InitCalls->Actions.Size + goal->ExitCalls->Actions.Size;
+		}
+
+		return numActions;
+	}
 
+	void RuleActionMap::AddRuleActionMappings(uint32_t firstNode, uint32_t firstGoal)
+	{
 		auto const & nodeDb = (*globals_.Nodes)->Db;
-		for (unsigned i = 0; i < nodeDb.Size; i++) {
+		for (unsigned i = firstNode; i < nodeDb.Size; i++) {
 			auto node = nodeDb.Start[i];
 			NodeType type = gNodeVMTWrappers->GetType(node);
 			if (type == NodeType::Rule) {
@@ -43,29 +112,135 @@ namespace dse
 		}
 
 		auto const & goalDb = (*globals_.Goals);
-		for (unsigned i = 0; i < goalDb->Count; i++) {
+		for (unsigned i = firstGoal; i < goalDb->Count; i++) {
 			auto goal = goalDb->Goals.Find(i + 1);
 			AddRuleActionMappings(nullptr, *goal, true, (*goal)->InitCalls);
 			AddRuleActionMappings(nullptr, *goal, false, (*goal)->ExitCalls);
 		}
 	}
 
+	void RuleActionMap::UpdateRuleActionMappings()
+	{
+		Reset(CountRuleActions(0, 0));
+		AddRuleActionMappings(0, 0);
+	}
+
+	bool RuleActionMap::MappingsMatch(Node * node, Goal * goal, bool isInit, RuleActionList * actions, std::size_t & numActions) const
+	{
+		auto head = actions->Actions.Head;
+		auto current = head->Next;
+		uint32_t actionIndex = 0;
+		while (current != head) {
+			auto mapping = Find(current->Item);
+			if (mapping == nullptr
+				|| mapping->rule != node
+				|| mapping->goal != goal
+				|| mapping->isInit != isInit
+				|| mapping->actionIndex != actionIndex) {
+				return false;
+			}
+
+			current = current->Next;
+			actionIndex++;
+		}
+
+		numActions += actionIndex;
+		return true;
+	}
+
+	bool RuleActionMap::ArePreMergeMappingsIntact() const
+	{
+		auto const & nodeDb = (*globals_.Nodes)->Db;
+		auto const & goalDb = (*globals_.Goals);
+		if (nodeDb.Size < mergeNodeCount_ || goalDb->Count < mergeGoalCount_) {
+			return false;
+		}
+
+		// Every action of the pre-merge rules and goals must still map to the same call site.
+		// Comparing action pointers (instead of list sizes) catches actions that were replaced
+		// in place, including reused allocations of freed actions.
+		std::size_t numActions = 0;
+		for (unsigned i = 0; i < mergeNodeCount_; i++) {
+			auto node = nodeDb.Start[i];
+			if (gNodeVMTWrappers->GetType(node) == NodeType::Rule
+				&& !MappingsMatch(node, nullptr, false, static_cast<RuleNode *>(node)->Calls, numActions)) {
+				return false;
+			}
+		}
+
+		for (unsigned i = 0; i < mergeGoalCount_; i++) {
+			auto goal = *goalDb->Goals.Find(i + 1);
+			if (!MappingsMatch(nullptr, goal, true, goal->InitCalls, numActions)
+				|| !MappingsMatch(nullptr, goal, false, goal->ExitCalls, numActions)) {
+				return false;
+			}
+		}
+
+		// Mappings of removed actions (or of rule nodes that were replaced by a different node type) would be left over
+		return numActions == numMappings_;
+	}
+
+	void RuleActionMap::BeginIncrementalUpdate()
+	{
+		mergeNodeCount_ = (*globals_.Nodes)->Db.Size;
+		mergeGoalCount_ = (*globals_.Goals)->Count;
+		hasMergeSnapshot_ = true;
+	}
+
+	void RuleActionMap::FinishIncrementalUpdate()
+	{
+		if (hasMergeSnapshot_ && ArePreMergeMappingsIntact()) {
+			auto numNewActions = CountRuleActions(mergeNodeCount_, mergeGoalCount_);
+			Rehash(numMappings_ + numNewActions);
+			AddRuleActionMappings(mergeNodeCount_, mergeGoalCount_);
+		} else {
+			// Existing rules or goals were modified by the merge
+			UpdateRuleActionMappings();
+		}
+
+		hasMergeSnapshot_ = false;
+	}
+
+	RuleActionMapping const * RuleActionMap::Find(RuleActionNode * action) const
+	{
+		if (numMappings_ > 0) {
+			auto mask = ruleActionMappings_.size() - 1;
+			auto slot = GetSlot(action);
+			while (ruleActionMappings_[slot].action != nullptr) {
+				if (ruleActionMappings_[slot].action == action) {
+					return &ruleActionMappings_[slot];
+				}
+
+				slot = (slot + 1) & mask;
+			}
+		}
+
+		return nullptr;
+	}
+
 	RuleActionMapping const * RuleActionMap::FindActionMapping(RuleActionNode * action)
 	{
-		auto mapping = ruleActionMappings_.find(action);
-		if (mapping == ruleActionMappings_.end()) {
-			WARN("Debugger::FindActionMapping(%016x): Could not find action mapping for rule action", action);
-			return nullptr;
+		auto mapping = Find(action);
+		if (mapping != nullptr) {
+			return mapping;
 		}
 
-		return &mapping->second;
+		WARN("Debugger::FindActionMapping(%016x): Could not find action mapping for rule action", action);
+		return nullptr;
 	}
 
 
 
-	BreakpointManager::BreakpointManager(OsirisStaticGlobals const & globals)
+	// Returns the GUID part of a "Name_<guid>" or "<guid>" string
+	static char const * GuidPart(char const * str)
+	{
+		auto length = strlen(str);
+		return (length > 36) ? (str + length - 36) : str;
+	}
+
+	BreakpointManager::BreakpointManager(OsirisStaticGlobals const & globals, DebugMessageHandler & messageHandler)
 		: breakpoints_(new std::unordered_map<uint64_t, Breakpoint>()),
-		globals_(globals)
+		globals_(globals), messageHandler_(messageHandler)
 	{}
 
 	ResultCode BreakpointManager::SetGlobalBreakpoints(GlobalBreakpointType breakpoints)
@@ -86,8 +261,70 @@ namespace dse
 		pendingBreakpoints_.reset(new std::unordered_map<uint64_t, Breakpoint>());
 	}
 
-	ResultCode BreakpointManager::AddBreakpoint(uint32_t nodeId, uint32_t goalId, bool isInit, int32_t actionIndex, BreakpointType type)
+	ResultCode BreakpointManager::CompileCondition(MsgBreakpointCondition const & msg, Condition & condition)
 	{
+		condition.column = msg.column();
+		condition.op = msg.op();
+
+		auto const & value = msg.value();
+		switch (value.value_case()) {
+		case MsgTypedValue::kIntval:
+			condition.kind = ConditionValueKind::Integer;
+			condition.intValue = value.intval();
+			break;
+
+		case MsgTypedValue::kFloatval:
+			condition.kind = ConditionValueKind::Real;
+			condition.floatValue = value.floatval();
+			break;
+
+		case MsgTypedValue::kStringval:
+			condition.kind = ConditionValueKind::String;
+			condition.stringValue = value.stringval();
+			break;
+
+		default:
+			WARN("Debugger::AddBreakpoint(): Condition on column %d has no value", msg.column());
+			return ResultCode::InvalidParameters;
+		}
+
+		switch (condition.op) {
+		case MsgBreakpointCondition_Operator_EQUAL:
+		case MsgBreakpointCondition_Operator_NOT_EQUAL:
+			return ResultCode::Success;
+
+		case MsgBreakpointCondition_Operator_LESS:
+		case MsgBreakpointCondition_Operator_LESS_EQUAL:
+		case MsgBreakpointCondition_Operator_GREATER:
+		case MsgBreakpointCondition_Operator_GREATER_EQUAL:
+			if (condition.kind == ConditionValueKind::String) {
+				WARN("Debugger::AddBreakpoint(): Ordered comparison needs a numeric value");
+				return ResultCode::InvalidParameters;
+			}
+			return ResultCode::Success;
+
+		case MsgBreakpointCondition_Operator_GUID_MATCH:
+			if (condition.kind != ConditionValueKind::String) {
+				WARN("Debugger::AddBreakpoint(): GUID match needs a string value");
+				return ResultCode::InvalidParameters;
+			}
+			condition.stringValue = std::string(GuidPart(condition.stringValue.c_str()));
+			return ResultCode::Success;
+
+		default:
+			WARN("Debugger::AddBreakpoint(): Unsupported condition operator %d", condition.op);
+			return ResultCode::InvalidParameters;
+		}
+	}
+
+	ResultCode BreakpointManager::AddBreakpoint(MsgBreakpoint const & msg)
+	{
+		auto nodeId = msg.node_id();
+		auto goalId = msg.goal_id();
+		auto isInit = msg.is_init_action();
+		auto actionIndex = msg.action_index();
+		auto type = (BreakpointType)msg.breakpoint_mask();
+
 		if (type & ~BreakpointTypeAll) {
 			WARN("Debugger::AddBreakpoint(): Unsupported breakpoint type set: %08x", type);
 			return ResultCode::UnsupportedBreakpointType;
@@ -117,6 +354,12 @@ namespace dse
 				breakpointId = MakeRuleActionBreakpointId(nodeId, actionIndex);
 			}
 			else if (goalId != 0) {
+				// Goal INIT/EXIT actions don't run in the context of a tuple
+				if (msg.condition_size() > 0) {
+					WARN("Debugger::AddBreakpoint(): Conditions are not supported on goal INIT/EXIT actions");
+					return ResultCode::InvalidParameters;
+				}
+
 				if (isInit) {
 					breakpointId = MakeGoalInitBreakpointId(goalId, actionIndex);
 				}
@@ -137,7 +380,19 @@ namespace dse
 		bp.isInit = isInit;
 		bp.actionIndex = actionIndex;
 		bp.type = type;
-		(*pendingBreakpoints_)[breakpointId] = bp;
+		bp.hitCountTarget = msg.hit_count();
+		bp.logOnly = msg.log_only();
+		bp.logMessage = msg.log_message();
+
+		bp.conditions.resize(msg.condition_size());
+		for (auto i = 0; i < msg.condition_size(); i++) {
+			auto rc = CompileCondition(msg.condition(i), bp.conditions[i]);
+			if (rc != ResultCode::Success) {
+				return rc;
+			}
+		}
+
+		(*pendingBreakpoints_)[breakpointId] = std::move(bp);
 
 		return ResultCode::Success;
 	}
@@ -148,12 +403,36 @@ namespace dse
 		if (pendingBps.get() != nullptr) {
 			DEBUG("BreakpointManager::FinishUpdatingNodeBreakpoints(): Syncing breakpoints in server thread");
 			this->breakpoints_.swap(pendingBps);
+			UpdateBreakpointTypes();
+		}
+	}
+
+	void BreakpointManager::UpdateBreakpointTypes()
+	{
+		nodeBreakpointTypes_.clear();
+		goalBreakpointTypes_.clear();
+
+		for (auto const & it : *breakpoints_) {
+			auto const & bp = it.second;
+			auto itemType = (BreakpointItemType)(it.first >> 56);
+			auto objectId = (uint32_t)it.first;
+			auto & types = (itemType == BP_Node || itemType == BP_RuleAction)
+				? nodeBreakpointTypes_
+				: goalBreakpointTypes_;
+
+			if (types.size() <= objectId) {
+				types.resize(objectId + 1, 0);
+			}
+
+			types[objectId] |= (uint8_t)bp.type;
 		}
 	}
 
 	void BreakpointManager::ClearAllBreakpoints()
 	{
 		globalBreakpoints_ = 0;
+		nodeBreakpointTypes_.clear();
+		goalBreakpointTypes_.clear();
 		breakpoints_->clear();
 		ClearForcedBreakpoints();
 	}
@@ -198,7 +477,7 @@ namespace dse
 		return ((uint64_t)BreakpointItemType::BP_GoalExit << 56) | ((uint64_t)actionIndex << 32) | goalId;
 	}
 
-	bool BreakpointManager::ForcedBreakpointConditionsSatisfied(std::vector<CallStackFrame> const & stack, 
+	bool BreakpointManager::ForcedBreakpointConditionsSatisfied(DebugCallStack const & stack, 
 		Node * bpNode, BreakpointType bpType)
 	{
 		// Check if the current frame type is one we can break on
@@ -207,7 +486,7 @@ namespace dse
 		}
 
 		// Check if we're on the correct stack depth
-		if (stack.size() > maxBreakDepth_) {
+		if (stack.Depth() > maxBreakDepth_) {
 			return false;
 		}
 
@@ -224,7 +503,7 @@ namespace dse
 		if (forceBreakpointFlags_ & ContinueSkipDbPropagation) {
 			// Look for a likely database propagation signature in the call stack
 			// (an Insert/Delete frame followed by a Pushdown frame)
-			for (auto i = 0; i < stack.size() - 1; i++) {
+			for (uint32_t i = 0; i + 1 < stack.NumFrames(); i++) {
 				auto & first = stack[i];
 				auto & second = stack[i + 1];
 
@@ -260,7 +539,139 @@ namespace dse
 		return true;
 	}
 
-	bool BreakpointManager::ShouldTriggerBreakpoint(std::vector<CallStackFrame> const & stack, Node * bpNode, 
+	static TypedValue const * GetFrameColumn(CallStackFrame const & frame, uint32_t column)
+	{
+		if (frame.tupleLL != nullptr) {
+			auto head = frame.tupleLL->Items.Head;
+			auto col = head->Next;
+			for (uint32_t i = 0; col != head; i++, col = col->Next) {
+				if (i == column) return &col->Item.Value;
+			}
+		} else if (frame.tuplePtrLL != nullptr) {
+			auto head = frame.tuplePtrLL->Items.Head;
+			auto col = head->Next;
+			for (uint32_t i = 0; col != head; i++, col = col->Next) {
+				if (i == column) return col->Item;
+			}
+		}
+
+		return nullptr;
+	}
+
+	template <class T>
+	static bool CompareOrdered(MsgBreakpointCondition_Operator op, T a, T b)
+	{
+		switch (op) {
+		case MsgBreakpointCondition_Operator_EQUAL: return a == b;
+		case MsgBreakpointCondition_Operator_NOT_EQUAL: return a != b;
+		case MsgBreakpointCondition_Operator_LESS: return a < b;
+		case MsgBreakpointCondition_Operator_LESS_EQUAL: return a <= b;
+		case MsgBreakpointCondition_Operator_GREATER: return a > b;
+		case MsgBreakpointCondition_Operator_GREATER_EQUAL: return a >= b;
+		default: return false;
+		}
+	}
+
+	bool BreakpointManager::ConditionMatches(Condition const & condition, CallStackFrame const & frame)
+	{
+		auto tv = GetFrameColumn(frame, condition.column);
+		if (tv == nullptr) {
+			return false;
+		}
+
+		auto const & val = tv->Value.Val;
+		switch ((ValueType)tv->TypeId) {
+		case ValueType::None:
+		case ValueType::Undefined:
+			return false;
+
+		case ValueType::Integer:
+		case ValueType::Integer64:
+		{
+			int64_t intVal = ((ValueType)tv->TypeId == ValueType::Integer) ? val.Int32 : val.Int64;
+			switch (condition.kind) {
+			case ConditionValueKind::Integer: return CompareOrdered(condition.op, intVal, condition.intValue);
+			case ConditionValueKind::Real: return CompareOrdered(condition.op, (double)intVal, (double)condition.floatValue);
+			default: return false;
+			}
+		}
+
+		case ValueType::Real:
+			switch (condition.kind) {
+			case ConditionValueKind::Integer: return CompareOrdered(condition.op, (double)val.Float, (double)condition.intValue);
+			case ConditionValueKind::Real: return CompareOrdered(condition.op, val.Float, condition.floatValue);
+			default: return false;
+			}
+
+		default:
+			if (condition.kind != ConditionValueKind::String || val.String == nullptr) {
+				return false;
+			}
+
+			switch (condition.op) {
+			case MsgBreakpointCondition_Operator_EQUAL: return strcmp(val.String, condition.stringValue.c_str()) == 0;
+			case MsgBreakpointCondition_Operator_NOT_EQUAL: return strcmp(val.String, condition.stringValue.c_str()) != 0;
+			case MsgBreakpointCondition_Operator_GUID_MATCH: return _stricmp(GuidPart(val.String), condition.stringValue.c_str()) == 0;
+			default: return false;
+			}
+		}
+	}
+
+	// Rule action frames have no tuple of their own; conditions on them are evaluated
+	// against the tuple of the rule that is executing the action
+	static CallStackFrame const * GetConditionFrame(DebugCallStack const & stack)
+	{
+		if (stack.Empty() || stack.Overflowed()) {
+			return nullptr;
+		}
+
+		auto const & top = stack.Top();
+		if (top.frameType != BreakpointReason::RuleActionCall) {
+			return &top;
+		}
+
+		for (auto i = stack.NumFrames() - 1; i > 0; i--) {
+			auto const & frame = stack[i - 1];
+			if (frame.node == top.node
+				&& (frame.tupleLL != nullptr || frame.tuplePtrLL != nullptr)) {
+				return &frame;
+			}
+		}
+
+		return nullptr;
+	}
+
+	bool BreakpointManager::BreakpointHit(Breakpoint & bp, DebugCallStack const & stack)
+	{
+		if (!bp.conditions.empty()) {
+			auto frame = GetConditionFrame(stack);
+			if (frame == nullptr) {
+				return false;
+			}
+
+			for (auto const & condition : bp.conditions) {
+				if (!ConditionMatches(condition, *frame)) {
+					return false;
+				}
+			}
+		}
+
+		bp.hits++;
+		if (bp.hits < bp.hitCountTarget) {
+			return false;
+		}
+
+		if (bp.logOnly) {
+			if (!stack.Empty()) {
+				messageHandler_.SendTracepointHit(stack.Top(), bp.logMessage, bp.hits);
+			}
+			return false;
+		}
+
+		return true;
+	}
+
+	bool BreakpointManager::ShouldTriggerBreakpoint(DebugCallStack const & stack, Node * bpNode, 
 		uint64_t bpNodeId, BreakpointType bpType, GlobalBreakpointType globalBpType)
 	{
 		if (debuggingDisabled_) {
@@ -268,10 +679,13 @@ namespace dse
 		}
 
 		// Check if there is a breakpoint on this node ID
-		auto it = breakpoints_->find(bpNodeId);
-		if (it != breakpoints_->end()
-			&& (it->second.type & bpType)) {
-			return true;
+		if (MayHaveBreakpoint(bpNodeId, bpType)) {
+			auto it = breakpoints_->find(bpNodeId);
+			if (it != breakpoints_->end()
+				&& (it->second.type & bpType)
+				&& BreakpointHit(it->second, stack)) {
+				return true;
+			}
 		}
 
 		// Check if there is a global breakpoint for this frame type
@@ -299,7 +713,7 @@ namespace dse
 		: globals_(globals), messageHandler_(messageHandler),
 		actionMappings_(globals),
 		debugAdapters_(globals),
-		breakpoints_(globals)
+		breakpoints_(globals, messageHandler)
 	{
 		if (messageHandler_.IsConnected()) {
 			breakpoints_.SetGlobalBreakpoints(
@@ -307,7 +721,22 @@ namespace dse
 		}
 
 		messageHandler_.SetDebugger(this);
+		DEBUG("Debugger::Debugger(): Attached to story");
+	}
+
+	Debugger::~Debugger()
+	{
+		DEBUG("Debugger::~Debugger(): Shutting down debugger");
+		Detach();
+		messageHandler_.SendDebugSessionEnded();
+		messageHandler_.SetDebugger(nullptr);
+	}
 
+	void Debugger::Attach()
+	{
+		if (isAttached_) return;
+
+		DEBUG("Debugger::Attach(): Enabling node hooks");
 		using namespace std::placeholders;
 		gNodeVMTWrappers->IsValidPreHook = std::bind(&Debugger::IsValidPreHook, this, _1, _2, _3);
 		gNodeVMTWrappers->IsValidPostHook = std::bind(&Debugger::IsValidPostHook, this, _1, _2, _3, _4);
@@ -317,15 +746,15 @@ namespace dse
 		gNodeVMTWrappers->InsertPostHook = std::bind(&Debugger::InsertPostHook, this, _1, _2, _3);
 		gNodeVMTWrappers->CallQueryPreHook = std::bind(&Debugger::CallQueryPreHook, this, _1, _2);
 		gNodeVMTWrappers->CallQueryPostHook = std::bind(&Debugger::CallQueryPostHook, this, _1, _2, _3);
-		DEBUG("Debugger::Debugger(): Attached to story");
+		callStack_.Clear();
+		isAttached_ = true;
 	}
 
-	Debugger::~Debugger()
+	void Debugger::Detach()
 	{
-		DEBUG("Debugger::~Debugger(): Shutting down debugger");
-		messageHandler_.SendDebugSessionEnded();
-		messageHandler_.SetDebugger(nullptr);
+		if (!isAttached_) return;
 
+		DEBUG("Debugger::Detach(): Disabling node hooks");
 		if (gNodeVMTWrappers) {
 			gNodeVMTWrappers->IsValidPreHook = std::function<void(Node *, VirtTupleLL *, AdapterRef *)>();
 			gNodeVMTWrappers->IsValidPostHook = std::function<void(Node *, VirtTupleLL *, AdapterRef *, bool)>();
@@ -336,6 +765,9 @@ namespace dse
 			gNodeVMTWrappers->CallQueryPreHook = std::function<void(Node *, OsiArgumentDesc *)>();
 			gNodeVMTWrappers->CallQueryPostHook = std::function<void(Node *, OsiArgumentDesc *, bool)>();
 		}
+
+		callStack_.Clear();
+		isAttached_ = false;
 	}
 
 	void Debugger::StoryLoaded()
@@ -361,6 +793,7 @@ namespace dse
 		// which breaks most debugger assumptions
 		debuggingDisabled_ = true;
 		breakpoints_.SetDebuggingDisabled(true);
+		actionMappings_.BeginIncrementalUpdate();
 	}
 
 	void Debugger::MergeFinished()
@@ -370,7 +803,7 @@ namespace dse
 		breakpoints_.SetDebuggingDisabled(false);
 
 		isInitialized_ = true;
-		actionMappings_.UpdateRuleActionMappings();
+		actionMappings_.FinishIncrementalUpdate();
 		if (breakpoints_.ShouldTriggerGlobalBreakpoint(GlobalBreakpointType::GlobalBreakOnGameInit)) {
 			GlobalBreakpointInServerThread(GlobalBreakpointReason::GameInit);
 		}
@@ -394,8 +827,58 @@ namespace dse
 		}
 	}
 
-	ResultCode Debugger::GetDatabaseContents(uint32_t databaseId)
+	static bool IsStringColumn(uint32_t typeId)
 	{
+		return typeId >= (uint32_t)ValueType::String;
+	}
+
+	static bool ColumnMatchesFilter(TypedValue const & tv, MsgColumnFilter const & filter)
+	{
+		auto const & value = filter.value();
+		auto const & val = tv.Value.Val;
+
+		switch (filter.op()) {
+		case MsgColumnFilter_Operator_EQUAL:
+			switch ((ValueType)tv.TypeId) {
+			case ValueType::None:
+			case ValueType::Undefined: return false;
+			case ValueType::Integer: return value.value_case() == MsgTypedValue::kIntval && val.Int32 == value.intval();
+			case ValueType::Integer64: return value.value_case() == MsgTypedValue::kIntval && val.Int64 == value.intval();
+			case ValueType::Real: return value.value_case() == MsgTypedValue::kFloatval && val.Float == value.floatval();
+			default: return value.value_case() == MsgTypedValue::kStringval && val.String != nullptr
+				&& strcmp(val.String, value.stringval().c_str()) == 0;
+			}
+
+		case MsgColumnFilter_Operator_GUID_MATCH:
+			return IsStringColumn(tv.TypeId) && val.String != nullptr
+				&& value.value_case() == MsgTypedValue::kStringval
+				&& _stricmp(GuidPart(val.String), GuidPart(value.stringval().c_str())) == 0;
+
+		case MsgColumnFilter_Operator_PREFIX:
+			return IsStringColumn(tv.TypeId) && val.String != nullptr
+				&& value.value_case() == MsgTypedValue::kStringval
+				&& strncmp(val.String, value.stringval().c_str(), value.stringval().size()) == 0;
+
+		default:
+			return false;
+		}
+	}
+
+	static bool RowMatchesFilters(TupleVec const & row, DbgGetDatabaseContents const & req)
+	{
+		for (auto const & filter : req.filter()) {
+			if (filter.column() >= row.Size
+				|| !ColumnMatchesFilter(row.Values[filter.column()], filter)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	ResultCode Debugger::GetDatabaseContents(DbgGetDatabaseContents const & req)
+	{
+		auto databaseId = req.database_id();
 		auto & dbs = (*globals_.Databases)->Db;
 		if (databaseId == 0 || databaseId > dbs.Size)
 		{
@@ -411,17 +894,51 @@ namespace dse
 		}
 
 		auto & db = dbs.Start[databaseId - 1];
+		for (auto const & filter : req.filter()) {
+			if (filter.column() >= db->NumParams) {
+				WARN("Debugger::GetDatabaseContents(): Filter column %d out of range", filter.column());
+				return ResultCode::InvalidParameters;
+			}
+		}
+
 		auto const & facts = db->Facts;
-		auto head = facts.Head;
-		auto current = head->Next;
 
 		messageHandler_.SendBeginDatabaseContents(databaseId);
-		while (current != head) {
-			messageHandler_.SendDatabaseRow(databaseId, &current->Item);
-			current = current->Next;
+
+		uint32_t matchingRows = 0, rowsSent = 0;
+		if (req.count_only() && req.filter_size() == 0) {
+			matchingRows = (uint32_t)facts.Size;
+		} else {
+			auto rangeEnd = (req.limit() > 0) ? ((uint64_t)req.offset() + req.limit()) : UINT64_MAX;
+			TupleVec * batch[DatabaseRowBatchSize];
+			uint32_t batchSize = 0;
+
+			auto head = facts.Head;
+			auto current = head->Next;
+			while (current != head) {
+				if (RowMatchesFilters(current->Item, req)) {
+					if (!req.count_only() && matchingRows >= req.offset() && matchingRows < rangeEnd) {
+						batch[batchSize++] = &current->Item;
+						if (batchSize == DatabaseRowBatchSize) {
+							messageHandler_.SendDatabaseRows(databaseId, batch, batchSize);
+							rowsSent += batchSize;
+							batchSize = 0;
+						}
+					}
+
+					matchingRows++;
+				}
+
+				current = current->Next;
+			}
+
+			if (batchSize > 0) {
+				messageHandler_.SendDatabaseRows(databaseId, batch, batchSize);
+				rowsSent += batchSize;
+			}
 		}
 
-		messageHandler_.SendEndDatabaseContents(databaseId);
+		messageHandler_.SendEndDatabaseContents(databaseId, matchingRows, rowsSent);
 
 		return ResultCode::Success;
 	}
@@ -467,7 +984,7 @@ namespace dse
 
 		case DbgContinue_Action_STEP_OVER:
 			// Step over the current frame; max depth is the current call stack depth
-			breakpoints_.SetForcedBreakpoints(true, breakpointMask, flags, (uint32_t)callStack_.size());
+			breakpoints_.SetForcedBreakpoints(true, breakpointMask, flags, callStack_.Depth());
 			break;
 
 		case DbgContinue_Action_STEP_INTO:
@@ -477,7 +994,7 @@ namespace dse
 
 		case DbgContinue_Action_STEP_OUT:
 			// Step out of the current frame; max depth is current - 1
-			breakpoints_.SetForcedBreakpoints(true, breakpointMask, flags, (uint32_t)callStack_.size() - 1);
+			breakpoints_.SetForcedBreakpoints(true, breakpointMask, flags, callStack_.Depth() - 1);
 			break;
 
 		default:
@@ -492,35 +1009,54 @@ namespace dse
 		return ResultCode::Success;
 	}
 
-	void Debugger::SyncStory()
+	void Debugger::SyncStory(std::vector<uint32_t> & goalIds)
 	{
 		auto const & goalDb = (*globals_.Goals);
-		for (unsigned i = 0; i < goalDb->Count; i++) {
-			auto goal = goalDb->Goals.Find(i + 1);
-			messageHandler_.SendSyncStory(*goal);
+		if (goalIds.empty()) {
+			for (unsigned i = 0; i < goalDb->Count; i++) {
+				auto goal = goalDb->Goals.Find(i + 1);
+				messageHandler_.SyncStoryGoal(*goal);
+			}
+		} else {
+			std::sort(goalIds.begin(), goalIds.end());
+			goalIds.erase(std::unique(goalIds.begin(), goalIds.end()), goalIds.end());
+			for (auto goalId : goalIds) {
+				auto goal = goalDb->Goals.Find(goalId);
+				if (goal != nullptr) {
+					messageHandler_.SyncStoryGoal(*goal);
+				} else {
+					WARN("Debugger::SyncStory(): Frontend requested nonexistent goal %d", goalId);
+				}
+			}
 		}
 
 		auto const & databaseDb = (*globals_.Databases)->Db;
-		for (unsigned i = 0; i < databaseDb.Size; i += 100) {
-			uint32_t numDatabases = std::min<uint32_t>(databaseDb.Size - i, 100);
-			messageHandler_.SendSyncStory(&databaseDb.Start[i], numDatabases);
+		for (unsigned i = 0; i < databaseDb.Size; i++) {
+			messageHandler_.SyncStoryDatabase(databaseDb.Start[i]);
 		}
 
 		auto const & nodeDb = (*globals_.Nodes)->Db;
-		for (unsigned i = 0; i < nodeDb.Size; i += 100) {
-			uint32_t numNodes = std::min<uint32_t>(nodeDb.Size - i, 100);
-			messageHandler_.SendSyncStory(&nodeDb.Start[i], numNodes);
+		for (unsigned i = 0; i < nodeDb.Size; i++) {
+			messageHandler_.SyncStoryNode(nodeDb.Start[i]);
 		}
 	}
 
-	void Debugger::Evaluate(uint32_t seq, EvalType type, uint32_t nodeId, MsgTuple const & params,
-		std::function<void(ResultCode, bool)> completionCallback)
+	void Debugger::Evaluate(uint32_t seq, EvalType type, uint32_t nodeId, MsgTuple const & params)
 	{
-		pendingActions_.push([=]() {
-			bool querySucceeded = false;
-			auto rc = this->EvaluateInServerThread(seq, type, nodeId, params, querySucceeded);
-			completionCallback(rc, querySucceeded);
-		});
+		std::size_t slot;
+		if (!pendingCommands_.TryReserve(slot)) {
+			WARN("Debugger::Evaluate(): Too many pending commands; server thread is not responding");
+			messageHandler_.SendEvaluateFinished(seq, ResultCode::TooManyPendingRequests, false);
+			return;
+		}
+
+		auto & command = pendingCommands_[slot];
+		command.Type = CommandType::Evaluate;
+		command.Eval = type;
+		command.Seq = seq;
+		command.NodeId = nodeId;
+		evalParams_[slot].CopyFrom(params);
+		pendingCommands_.Publish();
 		breakpointCv_.notify_one();
 	}
 
@@ -724,9 +1260,25 @@ namespace dse
 	void Debugger::ServerThreadReentry()
 	{
 		// Called when the debugger is entered from any of the server thread hooks
-		std::function<void ()> func;
-		while (pendingActions_.try_pop(func)) {
-			func();
+		std::size_t slot;
+		while (pendingCommands_.Peek(slot)) {
+			auto const & command = pendingCommands_[slot];
+			switch (command.Type) {
+			case CommandType::FinishUpdatingNodeBreakpoints:
+				breakpointUpdateQueued_ = false;
+				breakpoints_.FinishUpdatingNodeBreakpoints();
+				break;
+
+			case CommandType::Evaluate:
+			{
+				bool querySucceeded = false;
+				auto rc = EvaluateInServerThread(command.Seq, command.Eval, command.NodeId, evalParams_[slot], querySucceeded);
+				messageHandler_.SendEvaluateFinished(command.Seq, rc, querySucceeded);
+				break;
+			}
+			}
+
+			pendingCommands_.Consume();
 		}
 	}
 
@@ -740,14 +1292,27 @@ namespace dse
 	{
 		DEBUG("Debugger::FinishUpdatingNodeBreakpoints()");
 
-		pendingActions_.push([this]() {
-			breakpoints_.FinishUpdatingNodeBreakpoints();
-		});
+		// A queued update will pick up the latest breakpoint set as well
+		if (breakpointUpdateQueued_.exchange(true)) {
+			return;
+		}
+
+		std::size_t slot;
+		// Only evaluate commands can fill the ring, which are rejected when it's full; wait for them to drain
+		while (!pendingCommands_.TryReserve(slot)) {
+			std::this_thread::yield();
+		}
+
+		pendingCommands_[slot].Type = CommandType::FinishUpdatingNodeBreakpoints;
+		pendingCommands_.Publish();
 		breakpointCv_.notify_one();
 	}
 
 	void Debugger::ConditionalBreakpointInServerThread(Node * bpNode, uint64_t bpNodeId, BreakpointType bpType, GlobalBreakpointType globalBpType)
 	{
+		// Breakpoints are not supported past the max. call stack depth, as we don't have all frames
+		if (callStack_.Overflowed()) return;
+
 		if (breakpoints_.ShouldTriggerBreakpoint(callStack_, bpNode, bpNodeId, bpType, globalBpType)) {
 			FinishedSingleStep();
 			BreakpointInServerThread();
@@ -756,11 +1321,11 @@ namespace dse
 
 	void Debugger::BreakpointInServerThread()
 	{
-		if (callStack_.empty()) {
+		if (callStack_.Empty()) {
 			Fail("Tried to trigger breakpoint with empty callstack");
 		}
 
-		auto const & lastFrame = *callStack_.rbegin();
+		auto const & lastFrame = callStack_.Top();
 		DEBUG("Debugger::BreakpointInServerThread(): type %d", lastFrame.frameType);
 		{
 			std::unique_lock<std::mutex> lk(breakpointMutex_);
@@ -769,7 +1334,7 @@ namespace dse
 
 		QueryResultInfo * queryResults = nullptr;
 		if (hasLastQueryInfo_
-			&& callStack_.size() == lastQueryDepth_ - 1)
+			&& callStack_.Depth() == lastQueryDepth_ - 1)
 		{
 			queryResults = &lastQueryResults_;
 		}
@@ -807,16 +1372,21 @@ namespace dse
 
 	void Debugger::PushFrame(CallStackFrame const & frame)
 	{
-		callStack_.push_back(frame);
+		callStack_.Push(frame);
 	}
 
 	void Debugger::PopFrame(CallStackFrame const & frame)
 	{
-		if (callStack_.empty()) {
+		if (callStack_.Empty()) {
 			Fail("Tried to remove frame from empty callstack");
 		}
 
-		auto const & lastFrame = *callStack_.rbegin();
+		if (callStack_.Overflowed()) {
+			callStack_.Pop();
+			return;
+		}
+
+		auto const & lastFrame = callStack_.Top();
 		if (lastFrame.frameType != frame.frameType
 			|| lastFrame.node != frame.node
 			|| lastFrame.goal != frame.goal
@@ -826,7 +1396,7 @@ namespace dse
 			Fail("Call stack frame mismatch");
 		}
 
-		callStack_.pop_back();
+		callStack_.Pop();
 	}
 
 	void Debugger::IsValidPreHook(Node * node, VirtTupleLL * tuple, AdapterRef * adapter)
@@ -847,7 +1417,7 @@ namespace dse
 	void Debugger::IsValidPostHook(Node * node, VirtTupleLL * tuple, AdapterRef * adapter, bool succeeded)
 	{
 		hasLastQueryInfo_ = true;
-		lastQueryDepth_ = (uint32_t)callStack_.size();
+		lastQueryDepth_ = callStack_.Depth();
 		lastQueryResults_.queryNodeId = node->Id;
 		lastQueryResults_.succeeded = succeeded;
 		if (gNodeVMTWrappers->GetType(node) != NodeType::DivQuery
@@ -881,7 +1451,7 @@ namespace dse
 	{
 		// Trigger a failed query breakpoint if the last query didn't succeed
 		if (hasLastQueryInfo_
-			&& callStack_.size() == lastQueryDepth_ - 1
+			&& callStack_.Depth() == lastQueryDepth_ - 1
 			&& !lastQueryResults_.succeeded) {
 			ConditionalBreakpointInServerThread(
 				node,
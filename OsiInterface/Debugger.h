@@ -3,10 +3,11 @@
 #if !defined(OSI_NO_DEBUGGER)
 
 #include <cstdint>
-#include <concurrent_queue.h>
+#include <atomic>
 #include "osidebug.pb.h"
 #include <GameDefinitions/Osiris.h>
 #include "DebugMessages.h"
+#include "CommandRing.h"
 #include "OsirisHelpers.h"
 
 namespace dse
@@ -74,34 +75,59 @@ namespace dse
 		RuleActionMap(OsirisStaticGlobals const &);
 
 		void UpdateRuleActionMappings();
+		// Records the number of rules and goals present before a story merge, so only
+		// the rules and goals added by the merge need to be mapped afterwards
+		void BeginIncrementalUpdate();
+		void FinishIncrementalUpdate();
 		RuleActionMapping const * FindActionMapping(RuleActionNode * action);
 
 	private:
 		OsirisStaticGlobals const & globals_;
-		// Mapping of a rule action to its call site (rule then part, goal init/exit)
-		std::unordered_map<RuleActionNode *, RuleActionMapping> ruleActionMappings_;
-
+		// Open addressing table mapping rule actions to their call site (rule then part, goal init/exit).
+		// Empty slots have a null action pointer.
+		std::vector<RuleActionMapping> ruleActionMappings_;
+		std::size_t numMappings_{ 0 };
+		unsigned hashShift_{ 64 };
+
+		uint32_t mergeNodeCount_{ 0 };
+		uint32_t mergeGoalCount_{ 0 };
+		bool hasMergeSnapshot_{ false };
+
+		void Reset(std::size_t expectedMappings);
+		void Rehash(std::size_t capacity);
+		void Insert(RuleActionMapping const & mapping);
+		std::size_t CountRuleActions(uint32_t firstNode, uint32_t firstGoal);
+		void AddRuleActionMappings(uint32_t firstNode, uint32_t firstGoal);
 		void AddRuleActionMappings(Node * node, Goal * goal, bool isInit, RuleActionList * actions);
+		RuleActionMapping const * Find(RuleActionNode * action) const;
+		bool MappingsMatch(Node * node, Goal * goal, bool isInit, RuleActionList * actions, std::size_t & numActions) const;
+		bool ArePreMergeMappingsIntact() const;
+
+		inline std::size_t GetSlot(RuleActionNode * action) const
+		{
+			// Fibonacci hashing; the low bits of heap pointers are mostly zero
+			return (std::size_t)(((uint64_t)action * 0x9E3779B97F4A7C15ull) >> hashShift_);
+		}
 	};
 
 	class BreakpointManager
 	{
 	public:
-		BreakpointManager(OsirisStaticGlobals const &);
+		BreakpointManager(OsirisStaticGlobals const &, DebugMessageHandler & messageHandler);
 
 		ResultCode SetGlobalBreakpoints(GlobalBreakpointType type);
 		void ClearAllBreakpoints();
 		void BeginUpdatingNodeBreakpoints();
-		ResultCode AddBreakpoint(uint32_t nodeId, uint32_t goalId, bool isInit, int32_t actionIndex, BreakpointType type);
+		ResultCode AddBreakpoint(MsgBreakpoint const & msg);
 		void FinishUpdatingNodeBreakpoints();
 
 		void SetDebuggingDisabled(bool disabled);
 		void SetForcedBreakpoints(bool enabled, uint32_t bpMask, uint32_t flags, uint32_t maxDepth);
 		void ClearForcedBreakpoints();
 
-		bool ForcedBreakpointConditionsSatisfied(std::vector<CallStackFrame> const & stack, Node * bpNode, 
+		bool ForcedBreakpointConditionsSatisfied(DebugCallStack const & stack, Node * bpNode, 
 			BreakpointType bpType);
-		bool ShouldTriggerBreakpoint(std::vector<CallStackFrame> const & stack, Node * bpNode, uint64_t bpNodeId, 
+		bool ShouldTriggerBreakpoint(DebugCallStack const & stack, Node * bpNode, uint64_t bpNodeId, 
 			BreakpointType bpType, GlobalBreakpointType globalBpType);
 		bool ShouldTriggerGlobalBreakpoint(GlobalBreakpointType globalBpType);
 
@@ -111,6 +137,25 @@ namespace dse
 		static uint64_t MakeGoalExitBreakpointId(uint32_t goalId, uint32_t actionIndex);
 
 	private:
+		enum class ConditionValueKind : uint8_t
+		{
+			Integer,
+			Real,
+			String
+		};
+
+		// Breakpoint condition compiled from MsgBreakpointCondition
+		struct Condition
+		{
+			uint32_t column;
+			MsgBreakpointCondition_Operator op;
+			ConditionValueKind kind;
+			int64_t intValue;
+			float floatValue;
+			// String value; only the GUID part is kept for GUID_MATCH conditions
+			std::string stringValue;
+		};
+
 		struct Breakpoint
 		{
 			uint32_t nodeId;
@@ -118,6 +163,14 @@ namespace dse
 			bool isInit;
 			uint32_t actionIndex;
 			BreakpointType type;
+			std::vector<Condition> conditions;
+			// Number of condition matches needed before the breakpoint triggers
+			uint32_t hitCountTarget{ 0 };
+			// Number of condition matches so far; only updated on the server thread
+			uint32_t hits{ 0 };
+			// Tracepoint that logs hits instead of pausing
+			bool logOnly{ false };
+			std::string logMessage;
 		};
 
 		enum BreakpointItemType : uint8_t
@@ -129,6 +182,7 @@ namespace dse
 		};
 
 		OsirisStaticGlobals const & globals_;
+		DebugMessageHandler & messageHandler_;
 		// Is debugging disabled?
 		// (i.e. we don't stop on breakpoints)
 		bool debuggingDisabled_{ false };
@@ -137,6 +191,10 @@ namespace dse
 		std::unique_ptr<std::unordered_map<uint64_t, Breakpoint>> breakpoints_;
 		// Breakpoints that are being applied via the debugger protocol
 		std::unique_ptr<std::unordered_map<uint64_t, Breakpoint>> pendingBreakpoints_;
+		// Breakpoint types set on each node (node and rule action breakpoints) and goal (INIT/EXIT breakpoints).
+		// Used for rejecting breakpoint checks without a hash table lookup; rebuilt after each breakpoint update.
+		std::vector<uint8_t> nodeBreakpointTypes_;
+		std::vector<uint8_t> goalBreakpointTypes_;
 		// Forcibly triggers a breakpoint if all breakpoint conditions are met.
 		bool forceBreakpoint_{ false };
 		// Events that will trigger a forced breakpoint.
@@ -147,6 +205,22 @@ namespace dse
 		// Call stack depth at which we'll trigger a breakpoint
 		// (used for step over/into/out)
 		uint32_t maxBreakDepth_{ 0 };
+
+		void UpdateBreakpointTypes();
+		static ResultCode CompileCondition(MsgBreakpointCondition const & msg, Condition & condition);
+		static bool ConditionMatches(Condition const & condition, CallStackFrame const & frame);
+		// Evaluates conditions, hit count and tracepoint of a breakpoint; returns whether execution should pause
+		bool BreakpointHit(Breakpoint & bp, DebugCallStack const & stack);
+
+		inline bool MayHaveBreakpoint(uint64_t bpNodeId, BreakpointType bpType) const
+		{
+			auto itemType = (BreakpointItemType)(bpNodeId >> 56);
+			auto objectId = (uint32_t)bpNodeId;
+			auto const & types = (itemType == BP_Node || itemType == BP_RuleAction)
+				? nodeBreakpointTypes_
+				: goalBreakpointTypes_;
+			return objectId < types.size() && (types[objectId] & bpType) != 0;
+		}
 	};
 
 	class Debugger
@@ -159,6 +233,16 @@ namespace dse
 		void MergeStarted();
 		void MergeFinished();
 
+		// Install/remove the node hooks of the debugger.
+		// Must be called when no story code is executing, as call stack tracking starts from an empty stack.
+		void Attach();
+		void Detach();
+
+		inline bool IsAttached() const
+		{
+			return isAttached_;
+		}
+
 		inline bool IsInitialized() const
 		{
 			return isInitialized_;
@@ -175,11 +259,13 @@ namespace dse
 		}
 
 		void FinishUpdatingNodeBreakpoints();
-		ResultCode GetDatabaseContents(uint32_t databaseId);
+		ResultCode GetDatabaseContents(DbgGetDatabaseContents const & req);
 		ResultCode ContinueExecution(DbgContinue_Action action, uint32_t breakpointMask, uint32_t flags);
-		void SyncStory();
-		void Evaluate(uint32_t seq, EvalType type, uint32_t nodeId, MsgTuple const & params, 
-			std::function<void (ResultCode, bool)> completionCallback);
+		// Sends story data to the frontend; if goal IDs are specified, only those goals are sent.
+		// The filter is cosmetic: databases and nodes, which make up most of the data, are always
+		// sent in full (see DbgSyncStory).
+		void SyncStory(std::vector<uint32_t> & goalIds);
+		void Evaluate(uint32_t seq, EvalType type, uint32_t nodeId, MsgTuple const & params);
 
 		void GameInitHook();
 		void DeleteAllDataHook();
@@ -187,12 +273,33 @@ namespace dse
 		void RuleActionPostHook(RuleActionNode * action);
 
 	private:
+		enum class CommandType : uint8_t
+		{
+			FinishUpdatingNodeBreakpoints,
+			Evaluate
+		};
+
+		struct Command
+		{
+			CommandType Type;
+			EvalType Eval;
+			uint32_t Seq;
+			uint32_t NodeId;
+		};
+
+		static constexpr std::size_t CommandRingSize = 64;
+
+		// Max. number of database rows per BkDatabaseRow message
+		static constexpr uint32_t DatabaseRowBatchSize = 64;
+
 		OsirisStaticGlobals & globals_;
 		DebugMessageHandler & messageHandler_;
-		std::vector<CallStackFrame> callStack_;
+		DebugCallStack callStack_;
 		RuleActionMap actionMappings_;
 		// Did the engine call COsiris::InitGame() in this session?
 		bool isInitialized_{ false };
+		// Are the node hooks of the debugger installed?
+		bool isAttached_{ false };
 
 		std::mutex breakpointMutex_;
 		std::condition_variable breakpointCv_;
@@ -211,9 +318,15 @@ namespace dse
 		// Results of last div query
 		QueryResultInfo lastQueryResults_;
 
-		// Actions that we'll perform in the server thread instead of the messaging runtime thread.
+		// Commands that we'll perform in the server thread instead of the messaging runtime thread.
 		// This is needed to make sure that certain operations (eg. breakpoint update) execute in a thread-safe way.
-		Concurrency::concurrent_queue<std::function<void ()>> pendingActions_;
+		// Produced by the debugger message thread, consumed by the server thread.
+		CommandRing<Command, CommandRingSize> pendingCommands_;
+		// Parameters of evaluate commands, indexed by command slot
+		MsgTuple evalParams_[CommandRingSize];
+		// Is there a breakpoint update in the command ring that wasn't processed yet?
+		// (Breakpoint updates are coalesced, so they can't fill up the ring)
+		std::atomic<bool> breakpointUpdateQueued_{ false };
 
 		void ServerThreadReentry();
 
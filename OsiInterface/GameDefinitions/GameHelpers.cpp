@@ -593,6 +593,21 @@ namespace dse
 		}
 	}
 
+	void DamagePairList::AggregateSameTypeDamages()
+	{
+		for (uint32_t i = Size; i > 0; i--) {
+			auto & src = Buf[i - 1];
+			for (uint32_t j = i - 1; j > 0; j--) {
+				auto & dest = Buf[j - 1];
+				if (src.DamageType == dest.DamageType) {
+					dest.Amount += src.Amount;
+					Remove(i - 1);
+					break;
+				}
+			}
+		}
+	}
+
 
 	namespace esv
 	{
@@ -17,6 +17,7 @@ namespace dse
 	{
 		void AddDamage(DamageType damageType, int32_t amount);
 		void ClearDamage(DamageType damageType);
+		void AggregateSameTypeDamages();
 	};
 
 	struct HitDamageInfo
@@ -36,6 +36,8 @@ FS(GetTags);
 FS(GetStatus);
 FS(GetStatusByType);
 FS(GetStatuses);
+FS(GetInventoryItems);
+FS(GetProperties);
 FS(Stats);
 
 // Character stats
@@ -147,3 +149,6 @@ FS(StatObject);
 FS(StatId);
 FS(StatType);
 FS(Blob);
+FS(Accuracy);
+FS(Dodge);
+FS(ChanceToHitBoost);
@@ -72,6 +72,88 @@ namespace dse::lua
 	}
 
 
+	void EventListenerRegistry::AddEvent(char const* event)
+	{
+		listeners_.insert(std::make_pair(std::string_view(event), std::vector<RegistryEntry>()));
+	}
+
+	bool EventListenerRegistry::Add(lua_State* L, char const* event, int index)
+	{
+		auto it = listeners_.find(event);
+		if (it == listeners_.end()) {
+			return false;
+		}
+
+		it->second.push_back(RegistryEntry(L, index));
+		return true;
+	}
+
+	std::vector<RegistryEntry>* EventListenerRegistry::Get(char const* event)
+	{
+		auto it = listeners_.find(event);
+		if (it == listeners_.end() || it->second.empty()) {
+			return nullptr;
+		}
+
+		return &it->second;
+	}
+
+	void EventListenerRegistry::Clear()
+	{
+		for (auto& event : listeners_) {
+			event.second.clear();
+		}
+	}
+
+	bool CallListeners(lua_State* L, std::vector<RegistryEntry>& listeners, char const* event, int numArgs, int nres)
+	{
+		auto argsIndex = lua_gettop(L) - numArgs + 1;
+		// Listeners may register new listeners for the same event, so iterators can't be used here
+		for (std::size_t i = 0; i < listeners.size(); i++) {
+			listeners[i].Push();
+			for (auto arg = 0; arg < numArgs; arg++) {
+				lua_pushvalue(L, argsIndex + arg);
+			}
+
+			if (CallWithTraceback(L, numArgs, nres) != 0) { // stack: args, errmsg
+				OsiError("Error during " << event << ": " << lua_tostring(L, -1));
+				lua_pop(L, 1);
+			} else if (nres > 0 && !lua_isnil(L, -nres)) { // stack: args, results
+				for (auto arg = 0; arg < numArgs; arg++) {
+					lua_remove(L, argsIndex);
+				}
+				return true;
+			} else {
+				lua_pop(L, nres);
+			}
+		}
+
+		lua_pop(L, numArgs);
+		return false;
+	}
+
+	int RegisterListener(lua_State* L)
+	{
+		auto event = luaL_checkstring(L, 1);
+		luaL_checktype(L, 2, LUA_TFUNCTION);
+
+		auto added = State::FromLua(L)->Listeners.Add(L, event, 2);
+		push(L, added);
+		return 1;
+	}
+
+	int NotifyListeners(lua_State* L)
+	{
+		auto event = luaL_checkstring(L, 1);
+		auto listeners = State::FromLua(L)->Listeners.Get(event);
+		if (listeners != nullptr) {
+			CallListeners(L, *listeners, event, lua_gettop(L) - 1, 0);
+		}
+
+		return 0;
+	}
+
+
 	void PushExtFunction(lua_State * L, char const * func)
 	{
 		lua_getglobal(L, "Ext"); // stack: Ext
@@ -274,19 +356,35 @@ namespace dse::lua
 		}
 	}
 	
+	int CharacterStatsGetProperties(lua_State* L)
+	{
+		auto self = checked_get<ObjectProxy<CDivinityStats_Character>*>(L, 1);
+		auto stats = self->Get(L);
+		if (!stats) return 0;
+
+		return LuaFetchProperties(L, 2, [L, stats](char const* name, FixedString const& nameFS) {
+			return CharacterFetchStat(L, stats, name, nameFS);
+		});
+	}
+	
 	int ObjectProxy<CDivinityStats_Character>::Index(lua_State * L)
 	{
 		auto stats = Get(L);
 		if (!stats) return 0;
 		
 		auto prop = luaL_checkstring(L, 2);
-		auto fs = ToFixedString(prop);
+		auto fs = LuaToFixedString(L, 2);
 
 		if (fs == GFS.strGetItemBySlot) {
 			lua_pushcfunction(L, &CharacterGetItemBySlot);
 			return 1;
 		}
 
+		if (fs == GFS.strGetProperties) {
+			lua_pushcfunction(L, &CharacterStatsGetProperties);
+			return 1;
+		}
+
 		return CharacterFetchStat(L, stats, prop, fs);
 	}
 
@@ -295,8 +393,9 @@ namespace dse::lua
 		return luaL_error(L, "Not supported yet!");
 	}
 
-	int ItemFetchStat(lua_State * L, CDivinityStats_Item * item, char const * prop)
+	int ItemFetchStat(lua_State * L, CDivinityStats_Item * item, int propIndex)
 	{
+		auto prop = lua_tostring(L, propIndex);
 		if (strcmp(prop, "DynamicStats") == 0) {
 			lua_newtable(L);
 			unsigned statIdx = 1;
@@ -327,7 +426,7 @@ namespace dse::lua
 			return 1;
 		}
 
-		auto fetched = LuaPropertyMapGet(L, gItemStatsPropertyMap, item, prop, false);
+		auto fetched = LuaPropertyMapGet(L, gItemStatsPropertyMap, item, propIndex, false);
 		if (fetched) {
 			return 1;
 		}
@@ -353,8 +452,8 @@ namespace dse::lua
 		if (!stats) return 0;
 
 
-		auto prop = luaL_checkstring(L, 2);
-		return ItemFetchStat(L, stats, prop);
+		luaL_checkstring(L, 2);
+		return ItemFetchStat(L, stats, 2);
 	}
 
 	int ObjectProxy<CDivinityStats_Item>::NewIndex(lua_State * L)
@@ -377,9 +476,9 @@ namespace dse::lua
 		auto stats = Get(L);
 		if (!stats) return 0;
 
-		auto prop = luaL_checkstring(L, 2);
+		luaL_checkstring(L, 2);
 		auto & propMap = obj_->GetPropertyMap();
-		auto fetched = LuaPropertyMapGet(L, propMap, stats, prop, true);
+		auto fetched = LuaPropertyMapGet(L, propMap, stats, 2, true);
 		return fetched ? 1 : 0;
 	}
 
@@ -403,8 +502,8 @@ namespace dse::lua
 		auto stats = Get(L);
 		if (!stats) return 0;
 
-		auto prop = luaL_checkstring(L, 2);
-		auto fetched = LuaPropertyMapGet(L, gCharacterDynamicStatPropertyMap, stats, prop, true);
+		luaL_checkstring(L, 2);
+		auto fetched = LuaPropertyMapGet(L, gCharacterDynamicStatPropertyMap, stats, 2, true);
 		return fetched ? 1 : 0;
 	}
 
@@ -445,8 +544,8 @@ namespace dse::lua
 		auto stats = GetStaticSymbols().GetStats();
 		if (stats == nullptr || stats->ExtraData == nullptr) return luaL_error(L, "Stats not available");
 
-		auto key = luaL_checkstring(L, 2);
-		auto extraData = stats->ExtraData->Properties.Find(ToFixedString(key));
+		luaL_checkstring(L, 2);
+		auto extraData = stats->ExtraData->Properties.Find(LuaToFixedString(L, 2));
 		if (extraData != nullptr) {
 			push(L, *extraData);
 			return 1;
@@ -573,19 +672,7 @@ namespace dse::lua
 	int DamageList::AggregateSameTypeDamages(lua_State * L)
 	{
 		auto self = DamageList::CheckUserData(L, 1);
-
-		for (uint32_t i = self->damages_.Size; i > 0; i--) {
-			auto & src = self->damages_[i - 1];
-			for (uint32_t j = i - 1; j > 0; j--) {
-				auto & dest = self->damages_[j - 1];
-				if (src.DamageType == dest.DamageType) {
-					dest.Amount += src.Amount;
-					self->damages_.Remove(i - 1);
-					break;
-				}
-			}
-		}
-
+		self->damages_.AggregateSameTypeDamages();
 		return 0;
 	}
 
@@ -613,6 +700,7 @@ namespace dse::lua
 	void ExtensionLibrary::Register(lua_State * L)
 	{
 		RegisterLib(L);
+		RegisterGameMathLib(L);
 		ObjectProxy<CDivinityStats_Character>::RegisterMetatable(L);
 		ObjectProxy<CharacterDynamicStat>::RegisterMetatable(L);
 		ObjectProxy<CDivinityStats_Item>::RegisterMetatable(L);
@@ -711,6 +799,18 @@ namespace dse::lua
 #endif
 		lua_atpanic(L, &LuaPanic);
 		OpenLibs();
+
+		lua_pushlightuserdata(L, this);
+		lua_setfield(L, LUA_REGISTRYINDEX, "ExtState");
+
+		Listeners.AddEvent("ModuleLoadStarted");
+		Listeners.AddEvent("ModuleLoading");
+		Listeners.AddEvent("StatsLoaded");
+		Listeners.AddEvent("ModuleResume");
+		Listeners.AddEvent("SessionLoading");
+		Listeners.AddEvent("SessionLoaded");
+		Listeners.AddEvent("GetSkillDamage");
+		Listeners.AddEvent("GetHitChance");
 	}
 
 	void RestoreLevelMaps(std::unordered_set<int32_t> const &);
@@ -718,9 +818,21 @@ namespace dse::lua
 	State::~State()
 	{
 		RestoreLevelMaps(OverriddenLevelMaps);
+		// Registry entries must be released while the Lua state is still alive
+		Listeners.Clear();
+		// Cached property names may be anchored in this state
+		InvalidateLuaPropertyNameCache();
 		lua_close(L);
 	}
 
+	State* State::FromLua(lua_State* L)
+	{
+		lua_getfield(L, LUA_REGISTRYINDEX, "ExtState");
+		auto state = reinterpret_cast<State*>(lua_touserdata(L, -1));
+		lua_pop(L, 1);
+		return state;
+	}
+
 	void State::LoadBootstrap(STDString const& path, STDString const& modTable)
 	{
 		CallExt("_LoadBootstrap", RestrictAll, ReturnType<>{}, path, modTable);
@@ -763,12 +875,26 @@ namespace dse::lua
 		std::lock_guard lock(mutex_);
 		int top = lua_gettop(L);
 
-		/* Load the file containing the script we are going to run */
-		int status = luaL_loadbufferx(L, script.c_str(), script.size(), name.c_str(), "text");
-		if (status != LUA_OK) {
-			OsiError("Failed to parse script: " << lua_tostring(L, -1));
-			lua_pop(L, 1);  /* pop error message from the stack */
-			return {};
+		auto cache = gOsirisProxy->GetLuaBytecodeCache();
+		uint64_t cacheKey{ 0 };
+		bool cached{ false };
+		if (cache != nullptr) {
+			cacheKey = BytecodeCache::ComputeKey(script, name);
+			cached = cache->TryLoad(L, cacheKey, name);
+		}
+
+		if (!cached) {
+			/* Load the file containing the script we are going to run */
+			int status = luaL_loadbufferx(L, script.c_str(), script.size(), name.c_str(), "text");
+			if (status != LUA_OK) {
+				OsiError("Failed to parse script: " << lua_tostring(L, -1));
+				lua_pop(L, 1);  /* pop error message from the stack */
+				return {};
+			}
+
+			if (cache != nullptr) {
+				cache->Save(L, cacheKey);
+			}
 		}
 
 #if LUA_VERSION_NUM <= 501
@@ -779,7 +905,7 @@ namespace dse::lua
 #endif
 
 		/* Ask Lua to run our little script */
-		status = CallWithTraceback(L, 0, LUA_MULTRET);
+		int status = CallWithTraceback(L, 0, LUA_MULTRET);
 		if (status != LUA_OK) {
 			OsiError("Failed to execute script: " << lua_tostring(L, -1));
 			lua_pop(L, 1); // pop error message from the stack
@@ -792,14 +918,16 @@ namespace dse::lua
 	std::optional<int32_t> State::GetHitChance(CDivinityStats_Character * attacker, CDivinityStats_Character * target)
 	{
 		std::lock_guard lock(mutex_);
+		auto listeners = Listeners.Get("GetHitChance");
+		if (listeners == nullptr) return {};
+
 		Restriction restriction(*this, RestrictAll);
 
-		PushExtFunction(L, "_GetHitChance"); // stack: fn
 		auto _{ PushArguments(L,
 			std::tuple{Push<ObjectProxy<CDivinityStats_Character>>(attacker),
 			Push<ObjectProxy<CDivinityStats_Character>>(target)}) };
 
-		auto result = CheckedCall<std::optional<int32_t>>(L, 2, "Ext.GetHitChance");
+		auto result = CheckedCallListeners<std::optional<int32_t>>(L, *listeners, "GetHitChance", 2);
 		if (result) {
 			return std::get<0>(*result);
 		} else {
@@ -812,11 +940,12 @@ namespace dse::lua
 		float * targetPosition, DeathType * pDeathType, int level, bool noRandomization)
 	{
 		std::lock_guard lock(mutex_);
-		Restriction restriction(*this, RestrictAll);
+		auto listeners = Listeners.Get("GetSkillDamage");
+		if (listeners == nullptr) return false;
 
-		PushExtFunction(L, "_GetSkillDamage"); // stack: fn
+		Restriction restriction(*this, RestrictAll);
 
-		auto luaSkill = SkillPrototypeProxy::New(L, skill, -1); // stack: fn, skill
+		auto luaSkill = SkillPrototypeProxy::New(L, skill, -1); // stack: skill
 		UnbindablePin _(luaSkill);
 		ItemOrCharacterPushPin _a(L, attacker);
 
@@ -838,7 +967,7 @@ namespace dse::lua
 		push(L, level);
 		push(L, noRandomization);
 
-		auto result = CheckedCall<std::optional<DeathType>, std::optional<DamageList *>>(L, 8, "Ext.GetSkillDamage");
+		auto result = CheckedCallListeners<std::optional<DeathType>, std::optional<DamageList *>>(L, *listeners, "GetSkillDamage", 8);
 		if (result) {
 			auto deathType = std::get<0>(*result);
 			auto damages = std::get<1>(*result);
@@ -866,32 +995,32 @@ namespace dse::lua
 
 	void State::OnGameSessionLoading()
 	{
-		CallExt("_OnGameSessionLoading", RestrictAll | ScopeSessionLoad, ReturnType<>{});
+		Notify("SessionLoading", RestrictAll | ScopeSessionLoad);
 	}
 
 	void State::OnGameSessionLoaded()
 	{
-		CallExt("_OnGameSessionLoaded", RestrictAll, ReturnType<>{});
+		Notify("SessionLoaded", RestrictAll);
 	}
 
 	void State::OnModuleLoadStarted()
 	{
-		CallExt("_OnModuleLoadStarted", RestrictAll | ScopeModulePreLoad, ReturnType<>{});
+		Notify("ModuleLoadStarted", RestrictAll | ScopeModulePreLoad);
 	}
 
 	void State::OnModuleLoading()
 	{
-		CallExt("_OnModuleLoading", RestrictAll | ScopeModuleLoad, ReturnType<>{});
+		Notify("ModuleLoading", RestrictAll | ScopeModuleLoad);
 	}
 
 	void State::OnStatsLoaded()
 	{
-		CallExt("_OnStatsLoaded", RestrictAll | ScopeModuleLoad, ReturnType<>{});
+		Notify("StatsLoaded", RestrictAll | ScopeModuleLoad);
 	}
 
 	void State::OnModuleResume()
 	{
-		CallExt("_OnModuleResume", RestrictAll | ScopeModuleResume, ReturnType<>{});
+		Notify("ModuleResume", RestrictAll | ScopeModuleResume);
 	}
 
 	STDString State::GetBuiltinLibrary(int resourceId)
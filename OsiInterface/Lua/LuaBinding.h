@@ -7,6 +7,8 @@
 
 #include <mutex>
 #include <unordered_set>
+#include <unordered_map>
+#include <string_view>
 #include <optional>
 
 
@@ -154,6 +156,46 @@ namespace dse::lua
 		{}
 	};
 
+	// Lua functions registered for engine events using Ext.RegisterListener().
+	// Engine events check for listeners before pushing any arguments, so events that nobody
+	// listens to don't call into Lua at all.
+	class EventListenerRegistry
+	{
+	public:
+		// Event names must be string literals, as they're used as keys without copying
+		void AddEvent(char const* event);
+		// Registers the function at the specified stack index; returns false if the event is unknown
+		bool Add(lua_State* L, char const* event, int index);
+		// Returns the listeners of the event, or nullptr if there are none
+		std::vector<RegistryEntry>* Get(char const* event);
+		void Clear();
+
+	private:
+		std::unordered_map<std::string_view, std::vector<RegistryEntry>> listeners_;
+	};
+
+	// Calls each listener with the numArgs arguments on the top of the stack and pops the arguments.
+	// If nres > 0, stops at the first listener whose first return value is not nil, and
+	// leaves its nres return values on the stack; returns false if no listener returned a value.
+	bool CallListeners(lua_State* L, std::vector<RegistryEntry>& listeners, char const* event, int numArgs, int nres);
+
+	// Calls listeners with the arguments on the top of the stack and fetches the first
+	// non-nil result into a tuple. Returns {} if no listener returned a value or return value fetch failed.
+	template <class... Ret>
+	auto CheckedCallListeners(lua_State* L, std::vector<RegistryEntry>& listeners, char const* event, int numArgs)
+	{
+		if (!CallListeners(L, listeners, event, numArgs, (int)sizeof...(Ret))) {
+			return decltype(CheckedPopReturnValues<Ret...>(L))();
+		}
+
+		auto result = CheckedPopReturnValues<Ret...>(L);
+		if (!result) {
+			ERR("Got incorrect return values from %s listener", event);
+		}
+
+		return result;
+	}
+
 	class State
 	{
 	public:
@@ -178,6 +220,10 @@ namespace dse::lua
 
 		uint32_t RestrictionFlags{ 0 };
 		std::unordered_set<int32_t> OverriddenLevelMaps;
+		EventListenerRegistry Listeners;
+
+		// Returns the State that owns the specified Lua state
+		static State* FromLua(lua_State* L);
 
 		State();
 		~State();
@@ -221,6 +267,19 @@ namespace dse::lua
 			return CheckedCall<Ret...>(L, sizeof...(args), func);
 		}
 
+		// Calls the listeners of an event that has no return values
+		template <class... Args>
+		void Notify(char const* event, uint32_t restrictions, Args... args)
+		{
+			std::lock_guard lock(mutex_);
+			auto listeners = Listeners.Get(event);
+			if (listeners == nullptr) return;
+
+			Restriction restriction(*this, restrictions);
+			auto _{ PushArguments(L, std::tuple{args...}) };
+			CallListeners(L, *listeners, event, (int)sizeof...(args), 0);
+		}
+
 		std::optional<int> LoadScript(STDString const & script, STDString const & name = "", int globalsIdx = 0);
 
 		std::optional<int32_t> GetHitChance(CDivinityStats_Character * attacker, CDivinityStats_Character * target);
@@ -259,6 +318,8 @@ namespace dse::lua
 	};
 
 
+	int RegisterListener(lua_State* L);
+	int NotifyListeners(lua_State* L);
 	int GetExtensionVersion(lua_State* L);
 	int MonotonicTime(lua_State* L);
 	int OsiPrint(lua_State* L);
@@ -298,4 +359,6 @@ namespace dse::lua
 	int GetTranslatedString(lua_State* L);
 	int GetTranslatedStringFromKey(lua_State* L);
 	int GenerateIdeHelpers(lua_State* L);
+
+	void RegisterGameMathLib(lua_State* L);
 }
@@ -6,6 +6,11 @@ namespace dse
 {
 	struct InvokeDataValue;
 	struct UIObject;
+
+	namespace ig
+	{
+		struct FlashPlayer;
+	}
 }
 
 namespace dse::ecl::lua
@@ -79,14 +84,34 @@ namespace dse::ecl::lua
 	};
 
 
+	// Names of UI calls/invokes that have at least one handle, type or name listener
+	class UIListenerNameSet
+	{
+	public:
+		void Add(char const* name);
+		bool Contains(char const* name) const;
+
+	private:
+		std::unordered_set<STDString> names_;
+		// Views of the strings in names_, so lookups don't need to construct a string
+		std::unordered_set<std::string_view> lookup_;
+	};
+
+
 	class ClientState : public State
 	{
 	public:
+		UIListenerNameSet UICallNames;
+		UIListenerNameSet UIInvokeNames;
+
 		ClientState();
 		~ClientState();
 
+		// Checks whether the call/invoke should be forwarded to Lua at all
+		bool HasUICallListeners(const char* func);
+		bool HasUIInvokeListeners(const char* func);
 		void OnUICall(ObjectHandle uiObjectHandle, const char * func, unsigned int numArgs, InvokeDataValue * args);
-		void OnUIInvoke(ObjectHandle uiObjectHandle, const char* func, unsigned int numArgs, InvokeDataValue* args);
+		void OnUIInvoke(ObjectHandle uiObjectHandle, const char* func, unsigned int numArgs, InvokeDataValue* const* args);
 		std::optional<STDWString> SkillGetDescriptionParam(SkillPrototype * prototype,
 			CDivinityStats_Character * character, ObjectSet<STDString> const & paramTexts, bool isFromItem);
 		std::optional<STDWString> StatusGetDescriptionParam(StatusPrototype * prototype, CRPGStats_ObjectInstance* owner,
@@ -94,9 +119,13 @@ namespace dse::ecl::lua
 
 		void OnClientUIObjectCreated(char const * name, ObjectHandle handle);
 		UIObject * GetUIObject(char const * name);
+		ObjectHandle GetUIObjectHandle(ig::FlashPlayer* player);
 
 	private:
 		ExtensionLibraryClient library_;
 		std::unordered_map<STDString, ObjectHandle> clientUI_;
+		// UI object that owns each Flash player; entries are validated on lookup,
+		// as UI objects can be destroyed without us being notified
+		std::unordered_map<ig::FlashPlayer*, ObjectHandle> flashPlayerUI_;
 	};
 }
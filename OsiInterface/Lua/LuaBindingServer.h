@@ -42,6 +42,8 @@ namespace dse::esv::lua
 		Function const * function_{ nullptr };
 		AdapterRef adapter_;
 		ServerState * state_;
+		// Query results can be reused within the same Lua callback
+		bool memoize_{ false };
 
 		void OsiCall(lua_State * L);
 		void OsiInsert(lua_State * L, bool deleteTuple);
@@ -217,6 +219,9 @@ namespace dse::esv::lua
 		static int NewCall(lua_State * L);
 		static int NewQuery(lua_State * L);
 		static int NewEvent(lua_State * L);
+		static int MemoizeOsiQuery(lua_State * L);
+		static int GetOsiQueryCacheStats(lua_State * L);
+		static int ReplayOsirisTrace(lua_State * L);
 	};
 
 	inline void OsiReleaseArgument(OsiArgumentDesc & arg)
@@ -300,6 +305,97 @@ namespace dse::esv::lua
 	};
 
 
+	// Memoizes the results of side-effect free DIV queries called from Lua.
+	// Results are only reused within a single Osiris -> Lua callback; the cache is cleared
+	// when the outermost callback returns or when Lua calls anything that may change Osiris state.
+	class OsiQueryCache
+	{
+	public:
+		struct Stats
+		{
+			uint64_t Hits{ 0 };
+			uint64_t Misses{ 0 };
+		};
+
+		inline Stats const & GetStats() const
+		{
+			return stats_;
+		}
+
+		inline bool IsActive() const
+		{
+			return scopeDepth_ > 0;
+		}
+
+		inline void EnterScope()
+		{
+			scopeDepth_++;
+		}
+
+		inline void LeaveScope()
+		{
+			if (--scopeDepth_ == 0) {
+				Invalidate();
+			}
+		}
+
+		inline void Invalidate()
+		{
+			if (!results_.empty()) {
+				results_.clear();
+			}
+		}
+
+		void AddMemoizableQuery(STDString const & name);
+		bool IsMemoizable(STDString const & name) const;
+
+		// Builds the lookup key of a query call from the function handle and the IN arguments;
+		// returns false if the call can't be cached (a string argument is null)
+		bool MakeKey(Function const * func, OsiArgumentDesc const * args, STDString & key) const;
+		// Pushes the cached result of the call to the Lua stack;
+		// returns the number of pushed values or -1 if the call is not cached
+		int TryPush(lua_State * L, Function const * func, STDString const & key);
+		void Store(STDString && key, Function const * func, bool succeeded, OsiArgumentDesc const * args);
+
+	private:
+		struct CachedValue
+		{
+			OsiArgumentValue Value;
+			// Copy of the string value, as the original string is not owned by us
+			STDString String;
+		};
+
+		struct CachedResult
+		{
+			bool Succeeded;
+			std::vector<CachedValue> OutParams;
+		};
+
+		std::unordered_set<STDString> memoizableQueries_;
+		std::unordered_map<STDString, CachedResult> results_;
+		Stats stats_;
+		uint32_t scopeDepth_{ 0 };
+	};
+
+	class OsiQueryCacheScope
+	{
+	public:
+		inline OsiQueryCacheScope(OsiQueryCache & cache)
+			: cache_(cache)
+		{
+			cache_.EnterScope();
+		}
+
+		inline ~OsiQueryCacheScope()
+		{
+			cache_.LeaveScope();
+		}
+
+	private:
+		OsiQueryCache & cache_;
+	};
+
+
 	class ServerState : public State
 	{
 	public:
@@ -341,6 +437,11 @@ namespace dse::esv::lua
 			return tupleNodePool_;
 		}
 
+		inline OsiQueryCache & GetQueryCache()
+		{
+			return queryCache_;
+		}
+
 		void OnGameSessionLoading() override;
 
 		void StoryLoaded();
@@ -350,6 +451,7 @@ namespace dse::esv::lua
 		void Call(char const* mod, char const* func, std::vector<TArg> const & args)
 		{
 			std::lock_guard lock(mutex_);
+			OsiQueryCacheScope cacheScope(queryCache_);
 
 			auto L = GetState();
 			lua_checkstack(L, (int)args.size() + 1);
@@ -405,6 +507,7 @@ namespace dse::esv::lua
 		OsiArgumentPool<ListNode<TypedValue *>> tvNodePool_;
 		OsiArgumentPool<ListNode<TupleLL::Item>> tupleNodePool_;
 		IdentityAdapterMap identityAdapters_;
+		OsiQueryCache queryCache_;
 		// ID of current story instance.
 		// Used to invalidate function/node pointers in Lua userdata objects
 		uint32_t generationId_{ 0 };
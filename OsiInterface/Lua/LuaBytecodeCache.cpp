@@ -0,0 +1,177 @@
+#include <stdafx.h>
+#include <Lua/LuaBytecodeCache.h>
+#include <Version.h>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace dse::lua
+{
+	BytecodeCache::BytecodeCache(std::wstring const & directory)
+		: directory_(directory + L"\\LuaCache")
+	{
+		CreateDirectoryW(directory.c_str(), NULL);
+		CreateDirectoryW(directory_.c_str(), NULL);
+	}
+
+	// 64-bit FNV-1a
+	static constexpr uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+	static void HashBytes(uint64_t & hash, void const * data, std::size_t size)
+	{
+		auto bytes = reinterpret_cast<uint8_t const *>(data);
+		for (std::size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+	}
+
+	uint64_t BytecodeCache::ComputeKey(STDString const & script, STDString const & name)
+	{
+		uint64_t hash = HashSeed;
+		auto mix = [&hash](void const * data, std::size_t size) {
+			HashBytes(hash, data, size);
+		};
+
+		uint64_t sizes[2] = { script.size(), name.size() };
+		uint32_t versions[3] = { CurrentVersion, LUA_VERSION_NUM, (uint32_t)sizeof(void *) };
+		mix(sizes, sizeof(sizes));
+		mix(versions, sizeof(versions));
+		mix(LUA_RELEASE, sizeof(LUA_RELEASE) - 1);
+#if defined(LUAJIT_VERSION)
+		mix(LUAJIT_VERSION, sizeof(LUAJIT_VERSION) - 1);
+#endif
+		mix(name.data(), name.size());
+		mix(script.data(), script.size());
+		return hash;
+	}
+
+	std::wstring BytecodeCache::GetPath(uint64_t key) const
+	{
+		std::wstringstream ss;
+		ss << directory_ << L"\\" << std::hex << std::setw(16) << std::setfill(L'0') << key << L".luac";
+		return ss.str();
+	}
+
+	bool BytecodeCache::TryLoad(lua_State * L, uint64_t key, STDString const & name)
+	{
+		std::vector<char> bytecode;
+		CacheHeader header;
+		{
+			std::lock_guard lock(mutex_);
+			std::ifstream f(GetPath(key).c_str(), std::ios::in | std::ios::binary);
+			if (!f.good()) return false;
+
+			if (!f.read(reinterpret_cast<char *>(&header), sizeof(header))
+				|| header.Magic != CacheMagic
+				|| header.Version != CacheVersion
+				|| header.Key != key
+				|| header.BytecodeSize > MaxBytecodeSize) {
+				return false;
+			}
+
+			bytecode.resize(header.BytecodeSize);
+			if (!f.read(bytecode.data(), bytecode.size())) {
+				return false;
+			}
+		}
+
+		// The Lua loader doesn't verify bytecode, so a damaged file must not reach it
+		uint64_t hash = HashSeed;
+		HashBytes(hash, bytecode.data(), bytecode.size());
+		if (hash != header.BytecodeHash) {
+			WARN("BytecodeCache::TryLoad(): Cached bytecode of '%s' is corrupted", name.c_str());
+			Invalidate(key);
+			return false;
+		}
+
+		int status = luaL_loadbufferx(L, bytecode.data(), bytecode.size(), name.c_str(), "b");
+		if (status != LUA_OK) {
+			WARN("BytecodeCache::TryLoad(): Cached bytecode of '%s' could not be loaded: %s", name.c_str(), lua_tostring(L, -1));
+			lua_pop(L, 1);
+			Invalidate(key);
+			return false;
+		}
+
+		// Error messages and tracebacks rely on the chunk name and line info, so
+		// bytecode that was stripped of its debug info is not accepted
+		lua_Debug ar;
+		lua_pushvalue(L, -1);
+		lua_getinfo(L, ">SL", &ar);
+		bool hasDebugInfo = lua_istable(L, -1) && ar.source != nullptr && name == ar.source;
+		lua_pop(L, 1);
+
+		if (!hasDebugInfo) {
+			WARN("BytecodeCache::TryLoad(): Cached bytecode of '%s' has no debug info", name.c_str());
+			lua_pop(L, 1);
+			Invalidate(key);
+			return false;
+		}
+
+		return true;
+	}
+
+	static int BytecodeWriter(lua_State * L, void const * p, size_t size, void * ud)
+	{
+		auto bytecode = reinterpret_cast<std::vector<char> *>(ud);
+		auto bytes = reinterpret_cast<char const *>(p);
+		bytecode->insert(bytecode->end(), bytes, bytes + size);
+		return 0;
+	}
+
+	void BytecodeCache::Save(lua_State * L, uint64_t key)
+	{
+		std::vector<char> bytecode;
+#if LUA_VERSION_NUM > 501
+		int status = lua_dump(L, &BytecodeWriter, &bytecode, 0);
+#else
+		int status = lua_dump(L, &BytecodeWriter, &bytecode);
+#endif
+		if (status != 0 || bytecode.empty()) {
+			WARN("BytecodeCache::Save(): Failed to dump script bytecode");
+			return;
+		}
+
+		if (bytecode.size() > MaxBytecodeSize) {
+			return;
+		}
+
+		uint64_t hash = HashSeed;
+		HashBytes(hash, bytecode.data(), bytecode.size());
+		CacheHeader header{ CacheMagic, CacheVersion, key, bytecode.size(), hash };
+
+		// The cache directory may be shared by multiple game processes, so the file is written
+		// under a per-process name and moved into place, and readers never see a partial file
+		std::lock_guard lock(mutex_);
+		auto path = GetPath(key);
+		auto tempPath = path + L"." + std::to_wstring(GetCurrentProcessId()) + L".tmp";
+		{
+			std::ofstream f(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!f.good()) {
+				WARN(L"BytecodeCache::Save(): Could not open cache file '%s'", tempPath.c_str());
+				return;
+			}
+
+			f.write(reinterpret_cast<char const *>(&header), sizeof(header));
+			f.write(bytecode.data(), bytecode.size());
+			f.close();
+			if (f.fail()) {
+				WARN(L"BytecodeCache::Save(): Could not write cache file '%s'", tempPath.c_str());
+				DeleteFileW(tempPath.c_str());
+				return;
+			}
+		}
+
+		if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+			// Most likely another process is reading or replacing the same entry
+			WARN(L"BytecodeCache::Save(): Could not replace cache file '%s': error %d", path.c_str(), GetLastError());
+			DeleteFileW(tempPath.c_str());
+		}
+	}
+
+	void BytecodeCache::Invalidate(uint64_t key)
+	{
+		std::lock_guard lock(mutex_);
+		DeleteFileW(GetPath(key).c_str());
+	}
+}
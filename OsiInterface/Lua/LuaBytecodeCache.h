@@ -0,0 +1,55 @@
+#pragma once
+
+#include <GameDefinitions/BaseTypes.h>
+#include <Lua/LuaHelpers.h>
+#include <mutex>
+#include <string>
+
+namespace dse::lua
+{
+	// Caches the compiled bytecode of Lua scripts, so unchanged scripts don't need to be
+	// parsed again on every session start / Lua reset.
+	// Each script is stored in a separate file that is named after the cache key.
+	// Files are replaced atomically and their bytecode is checksummed.
+	// The key covers the script source, the chunk name (which is embedded in the debug info),
+	// the Lua version and the extender version; bytecode produced by a different
+	// Lua build is also rejected by the Lua loader itself.
+	class BytecodeCache
+	{
+	public:
+		BytecodeCache(std::wstring const & directory);
+
+		static uint64_t ComputeKey(STDString const & script, STDString const & name);
+
+		// Loads the cached chunk onto the stack; returns false (with nothing pushed) if
+		// the script is not cached or the cached bytecode is unusable
+		bool TryLoad(lua_State * L, uint64_t key, STDString const & name);
+		// Saves the function on the top of the stack
+		void Save(lua_State * L, uint64_t key);
+
+	private:
+		static constexpr uint32_t CacheMagic = 0x43554C44; // "DLUC"
+		static constexpr uint32_t CacheVersion = 2;
+		// Larger files are not cached (and are rejected when loading)
+		static constexpr uint64_t MaxBytecodeSize = 0x4000000; // 64 MB
+
+#pragma pack(push, 1)
+		struct CacheHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint64_t Key;
+			uint64_t BytecodeSize;
+			// Hash of the bytecode, checked before the bytecode is passed to the Lua loader
+			uint64_t BytecodeHash;
+		};
+#pragma pack(pop)
+
+		std::wstring directory_;
+		// Server and client states may load the same script concurrently
+		std::mutex mutex_;
+
+		std::wstring GetPath(uint64_t key) const;
+		void Invalidate(uint64_t key);
+	};
+}
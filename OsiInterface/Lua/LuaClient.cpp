@@ -21,9 +21,9 @@ namespace dse::lua
 	{
 		if (obj_ == nullptr) return luaL_error(L, "Status object no longer available");
 
-		auto prop = luaL_checkstring(L, 2);
+		luaL_checkstring(L, 2);
 		auto& propertyMap = ClientStatusToPropertyMap(obj_);
-		auto fetched = LuaPropertyMapGet(L, propertyMap, obj_, prop, true);
+		auto fetched = LuaPropertyMapGet(L, propertyMap, obj_, 2, true);
 		return fetched ? 1 : 0;
 	}
 
@@ -56,8 +56,8 @@ namespace dse::lua
 		auto customData = Get(L);
 		if (!customData) return 0;
 
-		auto prop = luaL_checkstring(L, 2);
-		auto fetched = LuaPropertyMapGet(L, gPlayerCustomDataPropertyMap, customData, prop, true);
+		luaL_checkstring(L, 2);
+		auto fetched = LuaPropertyMapGet(L, gPlayerCustomDataPropertyMap, customData, 2, true);
 		return fetched ? 1 : 0;
 	}
 
@@ -115,6 +115,22 @@ namespace dse::lua
 		return character;
 	}
 
+	int ClientCharacterGetProperties(lua_State* L)
+	{
+		auto self = checked_get<ObjectProxy<ecl::Character>*>(L, 1);
+		auto character = self->Get(L);
+		if (!character) return 0;
+
+		return LuaFetchProperties(L, 2, [L, character](char const* name, FixedString const& nameFS) {
+			if (!nameFS) {
+				OsiError("Illegal property name: " << name);
+				return 0;
+			}
+
+			return ClientCharacterFetchProperty(L, character, nameFS);
+		});
+	}
+
 #include <Lua/LuaShared.inl>
 
 	int ObjectProxy<ecl::Character>::Index(lua_State* L)
@@ -123,12 +139,17 @@ namespace dse::lua
 		if (!character) return 0;
 
 		auto prop = luaL_checkstring(L, 2);
-		auto propFS = ToFixedString(prop);
+		auto propFS = LuaToFixedString(L, 2);
 		if (!propFS) {
 			OsiError("Illegal property name: " << prop);
 			return 0;
 		}
 
+		if (propFS == GFS.strGetProperties) {
+			lua_pushcfunction(L, &ClientCharacterGetProperties);
+			return 1;
+		}
+
 		if (propFS == GFS.strHasTag) {
 			lua_pushcfunction(L, &GameObjectHasTag<ecl::Character>);
 			return 1;
@@ -179,7 +200,7 @@ namespace dse::lua
 		if (!item) return 0;
 
 		auto prop = luaL_checkstring(L, 2);
-		auto propFS = ToFixedString(prop);
+		auto propFS = LuaToFixedString(L, 2);
 
 		if (propFS == GFS.strHasTag) {
 			lua_pushcfunction(L, &GameObjectHasTag<ecl::Item>);
@@ -445,9 +466,9 @@ namespace dse::ecl::lua
 	{
 		auto status = Get(L);
 
-		auto prop = luaL_checkstring(L, 2);
+		luaL_checkstring(L, 2);
 		auto& propertyMap = ClientStatusToPropertyMap(status);
-		auto fetched = LuaPropertyMapGet(L, propertyMap, status, prop, true);
+		auto fetched = LuaPropertyMapGet(L, propertyMap, status, 2, true);
 		return fetched ? 1 : 0;
 	}
 
@@ -466,7 +487,7 @@ namespace dse::ecl::lua
 		void OnFunctionCalled(const char * func, unsigned int numArgs, InvokeDataValue * args)
 		{
 			LuaClientPin lua(ExtensionState::Get());
-			if (lua) {
+			if (lua && lua->HasUICallListeners(func)) {
 				lua->OnUICall(UIObjectHandle, func, numArgs, args);
 			}
 
@@ -865,7 +886,7 @@ namespace dse::ecl::lua
 	static void UIObjectFunctionCallCapture(UIObject* self, const char* function, unsigned int numArgs, InvokeDataValue* args)
 	{
 		LuaClientPin lua(ExtensionState::Get());
-		if (lua) {
+		if (lua && lua->HasUICallListeners(function)) {
 			lua->OnUICall(self->UIObjectHandle, function, numArgs, args);
 		}
 
@@ -917,21 +938,13 @@ namespace dse::ecl::lua
 	// Persistent for the lifetime of the app, as we don't restore FlashPlayer VMTs either
 	FlashPlayerHooks gFlashPlayerHooks;
 
-	ObjectHandle FindUIObjectHandle(ig::FlashPlayer* player)
+	static void OnFlashPlayerInvoke(ClientState& lua, ig::FlashPlayer* self, int64_t invokeId,
+		unsigned numArgs, InvokeDataValue* const* args)
 	{
-		auto uiManager = GetStaticSymbols().GetUIObjectManager();
-		if (uiManager == nullptr) {
-			OsiError("Couldn't get symbol for UIObjectManager!");
-			return {};
+		auto name = self->Invokes[(uint32_t)invokeId].Name;
+		if (lua.HasUIInvokeListeners(name)) {
+			lua.OnUIInvoke(lua.GetUIObjectHandle(self), name, numArgs, args);
 		}
-
-		for (auto const& ui : uiManager->UIObjects) {
-			if (ui->FlashPlayer == player) {
-				return ui->UIObjectHandle;
-			}
-		}
-
-		return {};
 	}
 
 	static bool FlashPlayerInvoke6Capture(ig::FlashPlayer* self, int64_t invokeId,
@@ -939,8 +952,8 @@ namespace dse::ecl::lua
 	{
 		LuaClientPin lua(ExtensionState::Get());
 		if (lua) {
-			std::vector<InvokeDataValue> args{ *a1, *a2, *a3, *a4, *a5, *a6 };
-			lua->OnUIInvoke(FindUIObjectHandle(self), self->Invokes[(uint32_t)invokeId].Name, (uint32_t)args.size(), args.data());
+			InvokeDataValue* args[] = { a1, a2, a3, a4, a5, a6 };
+			OnFlashPlayerInvoke(lua.Get(), self, invokeId, 6, args);
 		}
 
 		return gFlashPlayerHooks.OriginalInvoke6(self, invokeId, a1, a2, a3, a4, a5, a6);
@@ -951,8 +964,8 @@ namespace dse::ecl::lua
 	{
 		LuaClientPin lua(ExtensionState::Get());
 		if (lua) {
-			std::vector<InvokeDataValue> args{ *a1, *a2, *a3, *a4, *a5 };
-			lua->OnUIInvoke(FindUIObjectHandle(self), self->Invokes[(uint32_t)invokeId].Name, (uint32_t)args.size(), args.data());
+			InvokeDataValue* args[] = { a1, a2, a3, a4, a5 };
+			OnFlashPlayerInvoke(lua.Get(), self, invokeId, 5, args);
 		}
 
 		return gFlashPlayerHooks.OriginalInvoke5(self, invokeId, a1, a2, a3, a4, a5);
@@ -963,8 +976,8 @@ namespace dse::ecl::lua
 	{
 		LuaClientPin lua(ExtensionState::Get());
 		if (lua) {
-			std::vector<InvokeDataValue> args{ *a1, *a2, *a3, *a4 };
-			lua->OnUIInvoke(FindUIObjectHandle(self), self->Invokes[(uint32_t)invokeId].Name, (uint32_t)args.size(), args.data());
+			InvokeDataValue* args[] = { a1, a2, a3, a4 };
+			OnFlashPlayerInvoke(lua.Get(), self, invokeId, 4, args);
 		}
 
 		return gFlashPlayerHooks.OriginalInvoke4(self, invokeId, a1, a2, a3, a4);
@@ -975,8 +988,8 @@ namespace dse::ecl::lua
 	{
 		LuaClientPin lua(ExtensionState::Get());
 		if (lua) {
-			std::vector<InvokeDataValue> args{ *a1, *a2, *a3 };
-			lua->OnUIInvoke(FindUIObjectHandle(self), self->Invokes[(uint32_t)invokeId].Name, (uint32_t)args.size(), args.data());
+			InvokeDataValue* args[] = { a1, a2, a3 };
+			OnFlashPlayerInvoke(lua.Get(), self, invokeId, 3, args);
 		}
 
 		return gFlashPlayerHooks.OriginalInvoke3(self, invokeId, a1, a2, a3);
@@ -986,8 +999,8 @@ namespace dse::ecl::lua
 	{
 		LuaClientPin lua(ExtensionState::Get());
 		if (lua) {
-			std::vector<InvokeDataValue> args{ *a1, *a2 };
-			lua->OnUIInvoke(FindUIObjectHandle(self), self->Invokes[(uint32_t)invokeId].Name, (uint32_t)args.size(), args.data());
+			InvokeDataValue* args[] = { a1, a2 };
+			OnFlashPlayerInvoke(lua.Get(), self, invokeId, 2, args);
 		}
 
 		return gFlashPlayerHooks.OriginalInvoke2(self, invokeId, a1, a2);
@@ -997,7 +1010,7 @@ namespace dse::ecl::lua
 	{
 		LuaClientPin lua(ExtensionState::Get());
 		if (lua) {
-			lua->OnUIInvoke(FindUIObjectHandle(self), self->Invokes[(uint32_t)invokeId].Name, 1, a1);
+			OnFlashPlayerInvoke(lua.Get(), self, invokeId, 1, &a1);
 		}
 
 		return gFlashPlayerHooks.OriginalInvoke1(self, invokeId, a1);
@@ -1007,7 +1020,7 @@ namespace dse::ecl::lua
 	{
 		LuaClientPin lua(ExtensionState::Get());
 		if (lua) {
-			lua->OnUIInvoke(FindUIObjectHandle(self), self->Invokes[(uint32_t)invokeId].Name, 0, nullptr);
+			OnFlashPlayerInvoke(lua.Get(), self, invokeId, 0, nullptr);
 		}
 
 		return gFlashPlayerHooks.OriginalInvoke0(self, invokeId);
@@ -1017,7 +1030,21 @@ namespace dse::ecl::lua
 	{
 		LuaClientPin lua(ExtensionState::Get());
 		if (lua) {
-			lua->OnUIInvoke(FindUIObjectHandle(self), self->Invokes[(uint32_t)invokeId].Name, numArgs, args);
+			// Fixed buffer for the argument pointers; only unusually long invokes need a heap allocation
+			constexpr unsigned MaxInlineArgs = 16;
+			InvokeDataValue* inlineArgs[MaxInlineArgs];
+			std::vector<InvokeDataValue*> heapArgs;
+			InvokeDataValue** argPtrs = inlineArgs;
+			if (numArgs > MaxInlineArgs) {
+				heapArgs.resize(numArgs);
+				argPtrs = heapArgs.data();
+			}
+
+			for (unsigned i = 0; i < numArgs; i++) {
+				argPtrs[i] = &args[i];
+			}
+
+			OnFlashPlayerInvoke(lua.Get(), self, invokeId, numArgs, argPtrs);
 		}
 
 		return gFlashPlayerHooks.OriginalInvokeArgs(self, invokeId, args, numArgs);
@@ -1071,6 +1098,22 @@ namespace dse::ecl::lua
 	}
 
 
+	int RegisterUICallName(lua_State* L)
+	{
+		auto name = luaL_checkstring(L, 1);
+		static_cast<ClientState*>(State::FromLua(L))->UICallNames.Add(name);
+		return 0;
+	}
+
+
+	int RegisterUIInvokeName(lua_State* L)
+	{
+		auto name = luaL_checkstring(L, 1);
+		static_cast<ClientState*>(State::FromLua(L))->UIInvokeNames.Add(name);
+		return 0;
+	}
+
+
 	uint32_t NextCustomCreatorId = 1000;
 
 	int CreateUI(lua_State * L)
@@ -1226,6 +1269,8 @@ namespace dse::ecl::lua
 			{"Version", GetExtensionVersion},
 			{"MonotonicTime", MonotonicTime},
 			{"Include", Include},
+			{"_RegisterListener", RegisterListener},
+			{"_Notify", NotifyListeners},
 			{"Print", OsiPrint},
 			{"PrintWarning", OsiPrintWarning},
 			{"PrintError", OsiPrintError},
@@ -1276,6 +1321,8 @@ namespace dse::ecl::lua
 			{"GetUIByType", GetUIByType},
 			{"GetBuiltinUI", GetBuiltinUI},
 			{"DestroyUI", DestroyUI},
+			{"_RegisterUICallName", RegisterUICallName},
+			{"_RegisterUIInvokeName", RegisterUIInvokeName},
 			{0,0}
 		};
 
@@ -1288,6 +1335,11 @@ namespace dse::ecl::lua
 	{
 		library_.Register(L);
 
+		Listeners.AddEvent("SkillGetDescriptionParam");
+		Listeners.AddEvent("StatusGetDescriptionParam");
+		Listeners.AddEvent("UIInvoke");
+		Listeners.AddEvent("UICall");
+
 		auto baseLib = GetBuiltinLibrary(IDR_LUA_BUILTIN_LIBRARY);
 		LoadScript(baseLib, "BuiltinLibrary.lua");
 		auto clientLib = GetBuiltinLibrary(IDR_LUA_BUILTIN_LIBRARY_CLIENT);
@@ -1316,6 +1368,31 @@ namespace dse::ecl::lua
 		}
 	}
 
+	void UIListenerNameSet::Add(char const* name)
+	{
+		auto it = names_.insert(name);
+		if (it.second) {
+			lookup_.insert(std::string_view(*it.first));
+		}
+	}
+
+	bool UIListenerNameSet::Contains(char const* name) const
+	{
+		return lookup_.find(name) != lookup_.end();
+	}
+
+	bool ClientState::HasUICallListeners(const char* func)
+	{
+		std::lock_guard lock(mutex_);
+		return UICallNames.Contains(func) || Listeners.Get("UICall") != nullptr;
+	}
+
+	bool ClientState::HasUIInvokeListeners(const char* func)
+	{
+		std::lock_guard lock(mutex_);
+		return UIInvokeNames.Contains(func) || Listeners.Get("UIInvoke") != nullptr;
+	}
+
 	void ClientState::OnUICall(ObjectHandle uiObjectHandle, const char * func, unsigned int numArgs, InvokeDataValue * args)
 	{
 		std::lock_guard lock(mutex_);
@@ -1332,7 +1409,7 @@ namespace dse::ecl::lua
 		CheckedCall<>(L, 2 + numArgs, "Ext.UICall");
 	}
 
-	void ClientState::OnUIInvoke(ObjectHandle uiObjectHandle, const char* func, unsigned int numArgs, InvokeDataValue* args)
+	void ClientState::OnUIInvoke(ObjectHandle uiObjectHandle, const char* func, unsigned int numArgs, InvokeDataValue* const* args)
 	{
 		std::lock_guard lock(mutex_);
 		Restriction restriction(*this, RestrictAll);
@@ -1342,7 +1419,7 @@ namespace dse::ecl::lua
 		UIObjectProxy::New(L, uiObjectHandle);
 		push(L, func);
 		for (uint32_t i = 0; i < numArgs; i++) {
-			InvokeDataValueToLua(L, args[i]);
+			InvokeDataValueToLua(L, *args[i]);
 		}
 
 		CheckedCall<>(L, 2 + numArgs, "Ext.UIInvoke");
@@ -1352,6 +1429,9 @@ namespace dse::ecl::lua
 		CDivinityStats_Character * character, ObjectSet<STDString> const & paramTexts, bool isFromItem)
 	{
 		std::lock_guard lock(mutex_);
+		auto listeners = Listeners.Get("SkillGetDescriptionParam");
+		if (listeners == nullptr) return {};
+
 		Restriction restriction(*this, RestrictAll);
 
 		auto skill = prototype->GetStats();
@@ -1359,18 +1439,16 @@ namespace dse::ecl::lua
 			return {};
 		}
 
-		PushExtFunction(L, "_SkillGetDescriptionParam"); // stack: fn
-
 		auto _{ PushArguments(L,
 			std::tuple{Push<StatsProxy>(skill, std::optional<int32_t>()),
 			Push<ObjectProxy<CDivinityStats_Character>>(character)}) };
 		push(L, isFromItem);
 
 		for (auto const& paramText : paramTexts) {
-			push(L, paramText); // stack: fn, skill, character, params...
+			push(L, paramText); // stack: skill, character, isFromItem, params...
 		}
 
-		auto result = CheckedCall<std::optional<char const *>>(L, 3 + paramTexts.Set.Size, "Ext.SkillGetDescriptionParam");
+		auto result = CheckedCallListeners<std::optional<char const *>>(L, *listeners, "SkillGetDescriptionParam", 3 + paramTexts.Set.Size);
 		if (result) {
 			auto description = std::get<0>(*result);
 			if (description) {
@@ -1388,6 +1466,9 @@ namespace dse::ecl::lua
 		CRPGStats_ObjectInstance* statusSource, ObjectSet<STDString> const & paramTexts)
 	{
 		std::lock_guard lock(mutex_);
+		auto listeners = Listeners.Get("StatusGetDescriptionParam");
+		if (listeners == nullptr) return {};
+
 		Restriction restriction(*this, RestrictAll);
 
 		auto status = prototype->GetStats();
@@ -1395,17 +1476,15 @@ namespace dse::ecl::lua
 			return {};
 		}
 
-		PushExtFunction(L, "_StatusGetDescriptionParam"); // stack: fn
-
 		auto luaStatus = Push<StatsProxy>(status, std::optional<int32_t>())(L);
 		ItemOrCharacterPushPin luaSource(L, statusSource);
 		ItemOrCharacterPushPin luaOwner(L, owner);
 
 		for (auto const& paramText : paramTexts) {
-			push(L, paramText); // stack: fn, status, srcCharacter, character, params...
+			push(L, paramText); // stack: status, srcCharacter, character, params...
 		}
 
-		auto result = CheckedCall<std::optional<char const *>>(L, 3 + paramTexts.Set.Size, "Ext.StatusGetDescriptionParam");
+		auto result = CheckedCallListeners<std::optional<char const *>>(L, *listeners, "StatusGetDescriptionParam", 3 + paramTexts.Set.Size);
 		if (result) {
 			auto description = std::get<0>(*result);
 			if (description) {
@@ -1425,6 +1504,34 @@ namespace dse::ecl::lua
 	}
 
 
+	ObjectHandle ClientState::GetUIObjectHandle(ig::FlashPlayer* player)
+	{
+		auto uiManager = GetStaticSymbols().GetUIObjectManager();
+		if (uiManager == nullptr) {
+			OsiError("Couldn't get symbol for UIObjectManager!");
+			return {};
+		}
+
+		std::lock_guard lock(mutex_);
+		auto it = flashPlayerUI_.find(player);
+		if (it != flashPlayerUI_.end()) {
+			auto ui = uiManager->Get(it->second);
+			if (ui != nullptr && ui->FlashPlayer == player) {
+				return it->second;
+			}
+		}
+
+		for (auto const& ui : uiManager->UIObjects) {
+			if (ui->FlashPlayer == player) {
+				flashPlayerUI_[player] = ui->UIObjectHandle;
+				return ui->UIObjectHandle;
+			}
+		}
+
+		return {};
+	}
+
+
 	UIObject * ClientState::GetUIObject(char const * name)
 	{
 		auto it = clientUI_.find(name);
@@ -0,0 +1,292 @@
+#include <stdafx.h>
+#include <OsirisProxy.h>
+#include <PropertyMaps.h>
+#include <Lua/LuaBinding.h>
+
+namespace dse::lua
+{
+	// Native implementations of the self-contained Game.Math helpers.
+	// These must produce the same results as the original Lua code, including its rounding behavior.
+	// Mods may replace any Game.Math helper, so wherever the Lua code called another helper,
+	// the native code also calls it through the Game.Math table.
+
+	// Returned as a double, as Lua numbers are doubles; products with the integer stats
+	// must be computed in double precision to round the same way as the Lua code
+	static double GetExtraData(lua_State* L, char const* key)
+	{
+		auto stats = GetStaticSymbols().GetStats();
+		if (stats == nullptr || stats->ExtraData == nullptr) {
+			luaL_error(L, "Stats not available");
+		}
+
+		auto value = stats->ExtraData->Properties.Find(ToFixedString(key));
+		if (value == nullptr) {
+			luaL_error(L, "ExtraData value '%s' does not exist", key);
+		}
+
+		return *value;
+	}
+
+	static CDivinityStats_Character* CheckCharacterStats(lua_State* L, int index)
+	{
+		return checked_get<ObjectProxy<CDivinityStats_Character>*>(L, index)->Get(L);
+	}
+
+	static void PushGameMathFunction(lua_State* L, char const* name)
+	{
+		lua_getglobal(L, "Game"); // stack: Game
+		lua_getfield(L, -1, "Math"); // stack: Game, Math
+		lua_getfield(L, -1, name); // stack: Game, Math, fn
+		lua_replace(L, -3); // stack: fn, Math
+		lua_pop(L, 1); // stack: fn
+	}
+
+	static double CheckArithmeticOperand(lua_State* L, int index)
+	{
+		if (!lua_isnumber(L, index)) {
+			luaL_error(L, "attempt to perform arithmetic on a %s value", luaL_typename(L, index));
+		}
+
+		return lua_tonumber(L, index);
+	}
+
+	// Calls Game.Math.<name>(level) with the level argument at levelIndex
+	static double CallLevelFunction(lua_State* L, char const* name, int levelIndex)
+	{
+		PushGameMathFunction(L, name);
+		lua_pushvalue(L, levelIndex);
+		lua_call(L, 1, 1);
+		auto result = CheckArithmeticOperand(L, -1);
+		lua_pop(L, 1);
+		return result;
+	}
+
+	static double GetVitalityBoostByLevel(lua_State* L, double level)
+	{
+		auto expGrowth = GetExtraData(L, "VitalityExponentialGrowth");
+		auto growth = pow(expGrowth, level - 1);
+
+		static char const* const leaps[][2] = {
+			{ "FirstVitalityLeapLevel", "FirstVitalityLeapGrowth" },
+			{ "SecondVitalityLeapLevel", "SecondVitalityLeapGrowth" },
+			{ "ThirdVitalityLeapLevel", "ThirdVitalityLeapGrowth" },
+			{ "FourthVitalityLeapLevel", "FourthVitalityLeapGrowth" }
+		};
+
+		for (auto const& leap : leaps) {
+			if (level >= GetExtraData(L, leap[0])) {
+				growth = growth * GetExtraData(L, leap[1]) / expGrowth;
+			}
+		}
+
+		auto vit = level * GetExtraData(L, "VitalityLinearGrowth") + GetExtraData(L, "VitalityStartingAmount") * growth;
+		return round(vit / 5.0) * 5.0;
+	}
+
+	static void ApplyDamageSkillAbilityBonuses(lua_State* L, DamagePairList& damageList, CDivinityStats_Character* attacker)
+	{
+		int32_t magicArmorDamage = 0;
+		int32_t armorDamage = 0;
+
+		for (auto const& damage : damageList) {
+			switch (damage.DamageType) {
+			case DamageType::Magic:
+			case DamageType::Fire:
+			case DamageType::Air:
+			case DamageType::Water:
+			case DamageType::Earth:
+				magicArmorDamage += damage.Amount;
+				break;
+
+			case DamageType::Physical:
+			case DamageType::Corrosive:
+			case DamageType::Sulfuric:
+				armorDamage += damage.Amount;
+				break;
+			}
+		}
+
+		if (magicArmorDamage > 0) {
+			auto airSpecialist = attacker->GetAbility(AbilityType::AirSpecialist, false);
+			if (airSpecialist > 0) {
+				auto magicBonus = (double)airSpecialist * GetExtraData(L, "SkillAbilityDamageToMagicArmorPerPoint");
+				if (magicBonus > 0) {
+					damageList.AddDamage(DamageType::Magic, (int32_t)ceil(((double)magicArmorDamage * magicBonus) / 100.0));
+				}
+			}
+		}
+
+		if (armorDamage > 0) {
+			auto armorBonus = (double)attacker->GetAbility(AbilityType::WarriorLore, false) * GetExtraData(L, "SkillAbilityDamageToPhysicalArmorPerPoint");
+			if (armorBonus > 0) {
+				damageList.AddDamage(DamageType::Corrosive, (int32_t)ceil(((double)armorDamage * armorBonus) / 100.0));
+			}
+		}
+	}
+
+
+	int GameMathScaledDamageFromPrimaryAttribute(lua_State* L)
+	{
+		auto primaryAttr = luaL_checknumber(L, 1);
+		push(L, (primaryAttr - GetExtraData(L, "AttributeBaseValue")) * GetExtraData(L, "DamageBoostFromAttribute"));
+		return 1;
+	}
+
+	int GameMathGetVitalityBoostByLevel(lua_State* L)
+	{
+		auto level = luaL_checknumber(L, 1);
+		push(L, GetVitalityBoostByLevel(L, level));
+		return 1;
+	}
+
+	int GameMathGetLevelScaledDamage(lua_State* L)
+	{
+		auto level = luaL_checknumber(L, 1);
+		auto vitalityBoost = CallLevelFunction(L, "GetVitalityBoostByLevel", 1);
+		push(L, vitalityBoost / (((level - 1) * GetExtraData(L, "VitalityToDamageRatioGrowth")) + GetExtraData(L, "VitalityToDamageRatio")));
+		return 1;
+	}
+
+	int GameMathGetAverageLevelDamage(lua_State* L)
+	{
+		auto level = luaL_checknumber(L, 1);
+		auto scaled = CallLevelFunction(L, "GetLevelScaledDamage", 1);
+		push(L, ((level * GetExtraData(L, "ExpectedDamageBoostFromAttributePerLevel")) + 1.0) * scaled
+			* ((level * GetExtraData(L, "ExpectedDamageBoostFromSkillAbilityPerLevel")) + 1.0));
+		return 1;
+	}
+
+	int GameMathGetLevelScaledWeaponDamage(lua_State* L)
+	{
+		auto level = luaL_checknumber(L, 1);
+		auto scaledDmg = CallLevelFunction(L, "GetLevelScaledDamage", 1);
+		push(L, scaledDmg / ((level * GetExtraData(L, "ExpectedDamageBoostFromWeaponAbilityPerLevel")) + 1.0));
+		return 1;
+	}
+
+	int GameMathGetLevelScaledMonsterWeaponDamage(lua_State* L)
+	{
+		auto level = luaL_checknumber(L, 1);
+		auto weaponDmg = CallLevelFunction(L, "GetLevelScaledWeaponDamage", 1);
+		push(L, ((level * GetExtraData(L, "MonsterDamageBoostPerLevel")) + 1.0) * weaponDmg);
+		return 1;
+	}
+
+	int GameMathGetResistance(lua_State* L)
+	{
+		auto type = checked_get<DamageType>(L, 2);
+		// None and Chaos damage is never resisted
+		if (type == DamageType::None || type == DamageType::Chaos) {
+			push(L, 0);
+			return 1;
+		}
+
+		// Same lookup as character[type .. "Resistance"] in Lua; there is no resistance stat
+		// for some damage types (eg. Sulfuric), which yields nil there as well
+		STDString stat(EnumInfo<DamageType>::Find(type).Str);
+		stat += "Resistance";
+		lua_getfield(L, 1, stat.c_str());
+		return 1;
+	}
+
+	int GameMathApplyHitResistances(lua_State* L)
+	{
+		auto& damageList = DamageList::CheckUserData(L, 2)->Get();
+
+		// Resistances are calculated from the damages before any of them are applied
+		std::vector<TDamagePair> damages(damageList.Buf, damageList.Buf + damageList.Size);
+		PushGameMathFunction(L, "GetResistance"); // stack: GetResistance
+		for (auto const& damage : damages) {
+			lua_pushvalue(L, -1);
+			lua_pushvalue(L, 1);
+			push(L, damage.DamageType);
+			lua_call(L, 2, 1); // stack: GetResistance, resistance
+			auto resistance = CheckArithmeticOperand(L, -1);
+			lua_pop(L, 1);
+			damageList.AddDamage(damage.DamageType, (int32_t)floor(damage.Amount * -resistance / 100.0));
+		}
+
+		lua_pop(L, 1);
+		return 0;
+	}
+
+	int GameMathApplyDamageSkillAbilityBonuses(lua_State* L)
+	{
+		auto& damageList = DamageList::CheckUserData(L, 1)->Get();
+		if (lua_isnoneornil(L, 2)) return 0;
+
+		auto attacker = CheckCharacterStats(L, 2);
+		ApplyDamageSkillAbilityBonuses(L, damageList, attacker);
+		return 0;
+	}
+
+	int GameMathApplyDamageCharacterBonuses(lua_State* L)
+	{
+		lua_settop(L, 3);
+		auto& damageList = DamageList::CheckUserData(L, 3)->Get();
+		damageList.AggregateSameTypeDamages();
+
+		PushGameMathFunction(L, "ApplyHitResistances");
+		lua_pushvalue(L, 1);
+		lua_pushvalue(L, 3);
+		lua_call(L, 2, 0);
+
+		PushGameMathFunction(L, "ApplyDamageSkillAbilityBonuses");
+		lua_pushvalue(L, 3);
+		lua_pushvalue(L, 2);
+		lua_call(L, 2, 0);
+		return 0;
+	}
+
+	int GameMathCalculateHitChance(lua_State* L)
+	{
+		auto attacker = CheckCharacterStats(L, 1);
+		auto target = CheckCharacterStats(L, 2);
+
+		if (attacker->HasTalent(TalentType::Haymaker, false)) {
+			push(L, 100);
+			return 1;
+		}
+
+		// The original Lua implementation indexes the main weapon unconditionally
+		if (attacker->GetMainWeapon() == nullptr) {
+			return luaL_error(L, "attempt to index a nil value (field 'MainWeapon')");
+		}
+
+		auto accuracy = attacker->GetStat(GFS.strAccuracy, false).value_or(0);
+		int32_t dodge = 0;
+		// The original Lua implementation never detects ranged weapons (it passes the weapon type
+		// instead of the weapon to IsRangedWeapon), so invisible attackers ignore dodge regardless of their weapon
+		if (!(bool)(attacker->Flags & StatCharacterFlags::Invisible) && target->IsIncapacitatedRefCount == 0) {
+			dodge = target->GetStat(GFS.strDodge, false).value_or(0);
+		}
+
+		auto chanceToHit = (int32_t)round(((100.0 - dodge) * accuracy) / 100);
+		chanceToHit = std::max(0, std::min(100, chanceToHit));
+		push(L, chanceToHit + attacker->GetStat(GFS.strChanceToHitBoost, false).value_or(0));
+		return 1;
+	}
+
+	void RegisterGameMathLib(lua_State* L)
+	{
+		static const luaL_Reg mathLib[] = {
+			{"ScaledDamageFromPrimaryAttribute", GameMathScaledDamageFromPrimaryAttribute},
+			{"GetVitalityBoostByLevel", GameMathGetVitalityBoostByLevel},
+			{"GetLevelScaledDamage", GameMathGetLevelScaledDamage},
+			{"GetAverageLevelDamage", GameMathGetAverageLevelDamage},
+			{"GetLevelScaledWeaponDamage", GameMathGetLevelScaledWeaponDamage},
+			{"GetLevelScaledMonsterWeaponDamage", GameMathGetLevelScaledMonsterWeaponDamage},
+			{"GetResistance", GameMathGetResistance},
+			{"ApplyHitResistances", GameMathApplyHitResistances},
+			{"ApplyDamageSkillAbilityBonuses", GameMathApplyDamageSkillAbilityBonuses},
+			{"ApplyDamageCharacterBonuses", GameMathApplyDamageCharacterBonuses},
+			{"CalculateHitChance", GameMathCalculateHitChance},
+			{0,0}
+		};
+
+		lua_getglobal(L, "Ext"); // stack: Ext
+		luaL_newlib(L, mathLib); // stack: Ext, lib
+		lua_setfield(L, -2, "_NativeMath"); // stack: Ext
+		lua_pop(L, 1);
+	}
+}
@@ -1,5 +1,7 @@
 #include <stdafx.h>
 #include <OsirisProxy.h>
+#include <OsirisTraceReplay.h>
+#include <ScriptHelpers.h>
 #include "LuaBinding.h"
 #include <fstream>
 #include <regex>
@@ -259,6 +261,8 @@ namespace dse::esv::lua
 
 		function_ = func;
 		state_ = &state;
+		memoize_ = func->Type == FunctionType::Query
+			&& state.GetQueryCache().IsMemoizable(func->Signature->Name);
 		return true;
 	}
 
@@ -460,7 +464,12 @@ namespace dse::esv::lua
 			argType = argType->Next;
 		}
 
-		gOsirisProxy->GetWrappers().Call.CallWithHooks(function_->GetHandle(), funcArgs == 0 ? nullptr : args.Args());
+		{
+			StoryCallScope storyCall;
+			gOsirisProxy->GetWrappers().Call.CallWithHooks(function_->GetHandle(), funcArgs == 0 ? nullptr : args.Args());
+		}
+
+		state_->GetQueryCache().Invalidate();
 	}
 
 	void OsiFunction::OsiInsert(lua_State * L, bool deleteTuple)
@@ -495,11 +504,17 @@ namespace dse::esv::lua
 		}
 
 		auto node = function_->Node.Get();
-		if (deleteTuple) {
-			node->DeleteTuple(&tuple);
-		} else {
-			node->InsertTuple(&tuple);
+		gOsirisProxy->TraceStoryInsert(node, tuple, deleteTuple);
+		{
+			StoryCallScope storyCall;
+			if (deleteTuple) {
+				node->DeleteTuple(&tuple);
+			} else {
+				node->InsertTuple(&tuple);
+			}
 		}
+
+		state_->GetQueryCache().Invalidate();
 	}
 
 	int OsiFunction::OsiQuery(lua_State * L)
@@ -532,7 +547,32 @@ namespace dse::esv::lua
 			argType = argType->Next;
 		}
 
-		bool handled = gOsirisProxy->GetWrappers().Query.CallWithHooks(function_->GetHandle(), numParams == 0 ? nullptr : args.Args());
+		auto & cache = state_->GetQueryCache();
+		STDString cacheKey;
+		bool memoize = memoize_ && cache.IsActive();
+		bool cacheable = memoize && cache.MakeKey(function_, args.Args(), cacheKey);
+		if (cacheable) {
+			auto numResults = cache.TryPush(L, function_, cacheKey);
+			if (numResults >= 0) {
+				return numResults;
+			}
+		}
+
+		bool handled;
+		{
+			StoryCallScope storyCall;
+			handled = gOsirisProxy->GetWrappers().Query.CallWithHooks(function_->GetHandle(), numParams == 0 ? nullptr : args.Args());
+		}
+
+		if (memoize) {
+			if (cacheable) {
+				cache.Store(std::move(cacheKey), function_, handled, args.Args());
+			}
+		} else {
+			// Queries that weren't marked as side-effect free may have changed Osiris state
+			cache.Invalidate();
+		}
+
 		if (outParams == 0) {
 			push(L, handled);
 			return 1;
@@ -592,7 +632,14 @@ namespace dse::esv::lua
 		}
 
 		auto node = (*gOsirisProxy->GetGlobals().Nodes)->Db.Start[function_->Node.Id - 1];
-		bool valid = node->IsValid(&tuple, &adapter_);
+		bool valid;
+		{
+			StoryCallScope storyCall;
+			valid = node->IsValid(&tuple, &adapter_);
+		}
+
+		// User queries may execute actions in their rule body
+		state_->GetQueryCache().Invalidate();
 		if (valid) {
 			if (outParams > 0) {
 				auto retType = function_->Signature->Params->Params.Head->Next;
@@ -627,6 +674,118 @@ namespace dse::esv::lua
 
 
 
+	void OsiQueryCache::AddMemoizableQuery(STDString const & name)
+	{
+		memoizableQueries_.insert(name);
+	}
+
+	bool OsiQueryCache::IsMemoizable(STDString const & name) const
+	{
+		return memoizableQueries_.find(name) != memoizableQueries_.end();
+	}
+
+	bool OsiQueryCache::MakeKey(Function const * func, OsiArgumentDesc const * args, STDString & key) const
+	{
+		uint32_t handle = func->GetHandle();
+		key.append(reinterpret_cast<char const *>(&handle), sizeof(handle));
+
+		auto const & outParams = func->Signature->OutParamList;
+		auto numParams = func->Signature->Params->Params.Size;
+		for (uint32_t i = 0; i < numParams; i++) {
+			if (outParams.isOutParam(i)) continue;
+
+			auto const & arg = args[i].Value;
+			switch (arg.TypeId) {
+			case ValueType::Integer:
+				key.append(reinterpret_cast<char const *>(&arg.Int32), sizeof(arg.Int32));
+				break;
+
+			case ValueType::Integer64:
+				key.append(reinterpret_cast<char const *>(&arg.Int64), sizeof(arg.Int64));
+				break;
+
+			case ValueType::Real:
+				key.append(reinterpret_cast<char const *>(&arg.Float), sizeof(arg.Float));
+				break;
+
+			default:
+				// Null strings can't be told apart from empty ones in the key
+				if (arg.String == nullptr) {
+					return false;
+				}
+
+				// Include the terminator to keep adjacent string arguments apart
+				key.append(arg.String, strlen(arg.String) + 1);
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	int OsiQueryCache::TryPush(lua_State * L, Function const * func, STDString const & key)
+	{
+		auto it = results_.find(key);
+		if (it == results_.end()) {
+			stats_.Misses++;
+			return -1;
+		}
+
+		stats_.Hits++;
+		auto const & result = it->second;
+		auto outParams = func->Signature->OutParamList.numOutParams();
+		if (outParams == 0) {
+			push(L, result.Succeeded);
+			return 1;
+		}
+
+		if (result.Succeeded) {
+			for (auto const & value : result.OutParams) {
+				if (value.Value.TypeId == ValueType::Integer
+					|| value.Value.TypeId == ValueType::Integer64
+					|| value.Value.TypeId == ValueType::Real) {
+					OsiToLua(L, value.Value);
+				} else {
+					push(L, value.String.c_str());
+				}
+			}
+		} else {
+			for (uint32_t i = 0; i < outParams; i++) {
+				lua_pushnil(L);
+			}
+		}
+
+		return (int)outParams;
+	}
+
+	void OsiQueryCache::Store(STDString && key, Function const * func, bool succeeded, OsiArgumentDesc const * args)
+	{
+		CachedResult result;
+		result.Succeeded = succeeded;
+
+		if (succeeded) {
+			auto const & outParams = func->Signature->OutParamList;
+			auto numParams = func->Signature->Params->Params.Size;
+			for (uint32_t i = 0; i < numParams; i++) {
+				if (!outParams.isOutParam(i)) continue;
+
+				CachedValue value;
+				value.Value = args[i].Value;
+				if (value.Value.TypeId != ValueType::Integer
+					&& value.Value.TypeId != ValueType::Integer64
+					&& value.Value.TypeId != ValueType::Real) {
+					value.String = value.Value.String ? value.Value.String : "";
+					value.Value.String = nullptr;
+				}
+
+				result.OutParams.push_back(std::move(value));
+			}
+		}
+
+		results_.insert(std::make_pair(std::move(key), std::move(result)));
+	}
+
+
 	char const * const OsiFunctionNameProxy::MetatableName = "OsiFunctionNameProxy";
 
 	void OsiFunctionNameProxy::PopulateMetatable(lua_State * L)
@@ -828,6 +987,7 @@ namespace dse::esv::lua
 			return false;
 		}
 
+		OsiQueryCacheScope cacheScope(lua->GetQueryCache());
 		auto L = lua->GetState();
 		lua_checkstack(L, params.Count() + 1);
 		handler_.Push();
@@ -854,6 +1014,7 @@ namespace dse::esv::lua
 		std::vector<CustomFunctionParam> const & signature, OsiArgumentDesc & params)
 	{
 		std::lock_guard lock(mutex_);
+		OsiQueryCacheScope cacheScope(queryCache_);
 
 		auto L = GetState();
 		auto stackSize = lua_gettop(L);
@@ -1160,6 +1321,57 @@ namespace dse::esv::lua
 		return 0;
 	}
 
+	int ExtensionLibraryServer::MemoizeOsiQuery(lua_State * L)
+	{
+		LuaServerPin lua(ExtensionState::Get());
+		if (!lua) return luaL_error(L, "Exiting");
+
+		if (lua->StartupDone()) return luaL_error(L, "Attempted to mark query as memoizable after Lua startup phase");
+
+		auto funcName = luaL_checkstring(L, 1);
+		lua->GetQueryCache().AddMemoizableQuery(funcName);
+		return 0;
+	}
+
+	int ExtensionLibraryServer::GetOsiQueryCacheStats(lua_State * L)
+	{
+		LuaServerPin lua(ExtensionState::Get());
+		if (!lua) return luaL_error(L, "Exiting");
+
+		auto const & stats = lua->GetQueryCache().GetStats();
+		lua_newtable(L);
+		setfield(L, "Hits", stats.Hits);
+		setfield(L, "Misses", stats.Misses);
+		return 1;
+	}
+
+	int ExtensionLibraryServer::ReplayOsirisTrace(lua_State * L)
+	{
+		LuaServerPin lua(ExtensionState::Get());
+		if (!lua) return luaL_error(L, "Exiting");
+
+		if (!gOsirisProxy->GetConfig().DeveloperMode) {
+			OsiErrorS("Ext.ReplayOsirisTrace() is only available in developer mode");
+			return 0;
+		}
+
+		auto fileName = luaL_checkstring(L, 1);
+		auto path = script::GetPathForExternalIo(fileName);
+		if (!path) return 0;
+
+		OsirisTraceReplay replay;
+		if (!replay.Load(path->c_str())) return 0;
+
+		auto stats = replay.Run();
+		lua_newtable(L);
+		setfield(L, "Events", stats.Events);
+		setfield(L, "Inserts", stats.Inserts);
+		setfield(L, "Deletes", stats.Deletes);
+		setfield(L, "Skipped", stats.Skipped);
+		setfield(L, "Time", stats.Seconds);
+		return 1;
+	}
+
 	void ServerState::StoryLoaded()
 	{
 		generationId_++;
@@ -16,14 +16,19 @@ namespace dse::lua
 		if (obj_ == nullptr) return luaL_error(L, "Status object no longer available");
 
 		auto prop = luaL_checkstring(L, 2);
+		auto propFS = LuaToFixedString(L, 2);
+		if (!propFS) {
+			OsiError("Illegal property name: " << prop);
+			return 0;
+		}
 
-		if (strcmp(prop, "StatusType") == 0) {
+		if (propFS == GFS.strStatusType) {
 			push(L, obj_->GetStatusId());
 			return 1;
 		}
 
 		auto& propertyMap = StatusToPropertyMap(obj_);
-		auto fetched = LuaPropertyMapGet(L, propertyMap, obj_, prop, true);
+		auto fetched = LuaPropertyMapGet(L, propertyMap, obj_, propFS, true);
 		return fetched ? 1 : 0;
 	}
 
@@ -55,8 +60,8 @@ namespace dse::lua
 		auto customData = Get(L);
 		if (!customData) return 0;
 
-		auto prop = luaL_checkstring(L, 2);
-		auto fetched = LuaPropertyMapGet(L, gPlayerCustomDataPropertyMap, customData, prop, true);
+		luaL_checkstring(L, 2);
+		auto fetched = LuaPropertyMapGet(L, gPlayerCustomDataPropertyMap, customData, 2, true);
 		return fetched ? 1 : 0;
 	}
 
@@ -68,9 +73,9 @@ namespace dse::lua
 
 	char const* const ObjectProxy<esv::Character>::MetatableName = "esv::Character";
 
-	int ServerCharacterFetchProperty(lua_State* L, esv::Character* character, char const* prop)
+	int ServerCharacterFetchProperty(lua_State* L, esv::Character* character, FixedString const& prop)
 	{
-		if (strcmp(prop, "PlayerCustomData") == 0) {
+		if (prop == GFS.strPlayerCustomData) {
 			if (character->PlayerData != nullptr
 				&& character->PlayerData->CustomData.Initialized) {
 				ObjectHandle handle;
@@ -84,7 +89,7 @@ namespace dse::lua
 			}
 		}
 
-		if (strcmp(prop, "Stats") == 0) {
+		if (prop == GFS.strStats) {
 			if (character->Stats != nullptr) {
 				ObjectHandle handle;
 				character->GetObjectHandle(handle);
@@ -131,6 +136,22 @@ namespace dse::lua
 		return 1;
 	}
 
+	int ServerCharacterGetProperties(lua_State* L)
+	{
+		auto self = checked_get<ObjectProxy<esv::Character>*>(L, 1);
+		auto character = self->Get(L);
+		if (!character) return 0;
+
+		return LuaFetchProperties(L, 2, [L, character](char const* name, FixedString const& nameFS) {
+			if (!nameFS) {
+				OsiError("Illegal property name: " << name);
+				return 0;
+			}
+
+			return ServerCharacterFetchProperty(L, character, nameFS);
+		});
+	}
+
 #include <Lua/LuaShared.inl>
 
 	int ObjectProxy<esv::Character>::Index(lua_State* L)
@@ -139,38 +160,48 @@ namespace dse::lua
 		if (!character) return 0;
 
 		auto prop = luaL_checkstring(L, 2);
+		auto propFS = LuaToFixedString(L, 2);
+		if (!propFS) {
+			OsiError("Illegal property name: " << prop);
+			return 0;
+		}
 
-		if (strcmp(prop, "GetInventoryItems") == 0) {
+		if (propFS == GFS.strGetInventoryItems) {
 			lua_pushcfunction(L, &CharacterGetInventoryItems);
 			return 1;
 		}
 
-		if (strcmp(prop, "HasTag") == 0) {
+		if (propFS == GFS.strGetProperties) {
+			lua_pushcfunction(L, &ServerCharacterGetProperties);
+			return 1;
+		}
+
+		if (propFS == GFS.strHasTag) {
 			lua_pushcfunction(L, &GameObjectHasTag<esv::Character>);
 			return 1;
 		}
 
-		if (strcmp(prop, "GetTags") == 0) {
+		if (propFS == GFS.strGetTags) {
 			lua_pushcfunction(L, &GameObjectGetTags<esv::Character>);
 			return 1;
 		}
 
-		if (strcmp(prop, "GetStatus") == 0) {
+		if (propFS == GFS.strGetStatus) {
 			lua_pushcfunction(L, (&GameObjectGetStatus<esv::Character, esv::Status>));
 			return 1;
 		}
 
-		if (strcmp(prop, "GetStatusByType") == 0) {
+		if (propFS == GFS.strGetStatusByType) {
 			lua_pushcfunction(L, (&GameObjectGetStatusByType<esv::Character, esv::Status>));
 			return 1;
 		}
 
-		if (strcmp(prop, "GetStatuses") == 0) {
+		if (propFS == GFS.strGetStatuses) {
 			lua_pushcfunction(L, (&GameObjectGetStatuses<esv::Character>));
 			return 1;
 		}
 
-		return ServerCharacterFetchProperty(L, character, prop);
+		return ServerCharacterFetchProperty(L, character, propFS);
 	}
 
 	int ObjectProxy<esv::Character>::NewIndex(lua_State* L)
@@ -195,7 +226,7 @@ namespace dse::lua
 		if (!item) return 0;
 
 		auto prop = luaL_checkstring(L, 2);
-		auto propFS = ToFixedString(prop);
+		auto propFS = LuaToFixedString(L, 2);
 
 		if (propFS == GFS.strHasTag) {
 			lua_pushcfunction(L, &GameObjectHasTag<esv::Item>);
@@ -266,8 +297,8 @@ namespace dse::lua
 		auto projectile = Get(L);
 		if (!projectile) return 0;
 
-		auto prop = luaL_checkstring(L, 2);
-		bool fetched = LuaPropertyMapGet(L, gProjectilePropertyMap, projectile, prop, true);
+		luaL_checkstring(L, 2);
+		bool fetched = LuaPropertyMapGet(L, gProjectilePropertyMap, projectile, 2, true);
 		return fetched ? 1 : 0;
 	}
 
@@ -298,8 +329,8 @@ namespace dse::lua
 		auto surface = Get(L);
 		if (!surface) return 0;
 
-		auto prop = luaL_checkstring(L, 2);
-		auto propFS = ToFixedString(prop);
+		luaL_checkstring(L, 2);
+		auto propFS = LuaToFixedString(L, 2);
 
 		return LuaPropertyMapGet(L, gEsvSurfacePropertyMap, surface, propFS, true) ? 1 : 0;
 	}
@@ -331,9 +362,9 @@ namespace dse::esv::lua
 
 		if (status == nullptr) return luaL_error(L, "Status handle invalid");
 
-		auto prop = luaL_checkstring(L, 2);
+		luaL_checkstring(L, 2);
 		auto& propertyMap = StatusToPropertyMap(status);
-		auto fetched = LuaPropertyMapGet(L, propertyMap, status, prop, true);
+		auto fetched = LuaPropertyMapGet(L, propertyMap, status, 2, true);
 		return fetched ? 1 : 0;
 	}
 
@@ -959,9 +990,14 @@ namespace dse::esv::lua
 			{"Version", GetExtensionVersion},
 			{"MonotonicTime", MonotonicTime},
 			{"Include", Include},
+			{"_RegisterListener", RegisterListener},
+			{"_Notify", NotifyListeners},
 			{"NewCall", NewCall},
 			{"NewQuery", NewQuery},
 			{"NewEvent", NewEvent},
+			{"MemoizeOsiQuery", MemoizeOsiQuery},
+			{"GetOsiQueryCacheStats", GetOsiQueryCacheStats},
+			{"ReplayOsirisTrace", ReplayOsirisTrace},
 			{"Print", OsiPrint},
 			{"PrintWarning", OsiPrintWarning},
 			{"PrintError", OsiPrintError},
@@ -1030,6 +1066,11 @@ namespace dse::esv::lua
 
 		library_.Register(L);
 
+		Listeners.AddEvent("ComputeCharacterHit");
+		Listeners.AddEvent("CalculateTurnOrder");
+		Listeners.AddEvent("StatusGetEnterChance");
+		Listeners.AddEvent("BeforeCharacterApplyDamage");
+
 		auto baseLib = GetBuiltinLibrary(IDR_LUA_BUILTIN_LIBRARY);
 		LoadScript(baseLib, "BuiltinLibrary.lua");
 		auto serverLib = GetBuiltinLibrary(IDR_LUA_BUILTIN_LIBRARY_SERVER);
@@ -1060,14 +1101,16 @@ namespace dse::esv::lua
 	std::optional<int32_t> ServerState::StatusGetEnterChance(esv::Status * status, bool isEnterCheck)
 	{
 		std::lock_guard lock(mutex_);
+		auto listeners = Listeners.Get("StatusGetEnterChance");
+		if (listeners == nullptr) return {};
+
 		Restriction restriction(*this, RestrictOsiris);
 
-		PushExtFunction(L, "_StatusGetEnterChance"); // stack: fn
 		auto _{ PushArguments(L,
 			std::tuple{Push<ObjectProxy<esv::Status>>(status)}) };
 		push(L, isEnterCheck);
 
-		auto result = CheckedCall<std::optional<int32_t>>(L, 2, "Ext.StatusGetEnterChance");
+		auto result = CheckedCallListeners<std::optional<int32_t>>(L, *listeners, "StatusGetEnterChance", 2);
 		if (result) {
 			return std::get<0>(*result);
 		} else {
@@ -1134,9 +1177,10 @@ namespace dse::esv::lua
 		CRPGStats_Object_Property_List *skillProperties, HighGroundBonus highGroundFlag, CriticalRoll criticalRoll)
 	{
 		std::lock_guard lock(mutex_);
-		Restriction restriction(*this, RestrictOsiris);
+		auto listeners = Listeners.Get("ComputeCharacterHit");
+		if (listeners == nullptr) return false;
 
-		PushExtFunction(L, "_ComputeCharacterHit"); // stack: fn
+		Restriction restriction(*this, RestrictOsiris);
 
 		auto luaTarget = ObjectProxy<CDivinityStats_Character>::New(L, target);
 		UnbindablePin _(luaTarget);
@@ -1168,18 +1212,12 @@ namespace dse::esv::lua
 		push(L, highGroundFlag);
 		push(L, criticalRoll);
 
-		if (CallWithTraceback(L, 11, 1) != 0) { // stack: succeeded
-			OsiError("ComputeCharacterHit handler failed: " << lua_tostring(L, -1));
-			lua_pop(L, 1);
+		if (!CallListeners(L, *listeners, "ComputeCharacterHit", 11, 1)) { // stack: hit
 			return false;
 		}
 
-		int isnil = lua_isnil(L, -1);
-
 		bool ok;
-		if (isnil) {
-			ok = false;
-		} else if (lua_type(L, -1) == LUA_TTABLE) {
+		if (lua_type(L, -1) == LUA_TTABLE) {
 			lua_getfield(L, -1, "EffectFlags");
 			auto effectFlags = lua_tointeger(L, -1);
 			lua_pop(L, 1);
@@ -1223,9 +1261,14 @@ namespace dse::esv::lua
 			CauseType causeType, glm::vec3& impactDirection)
 	{
 		std::lock_guard lock(mutex_);
+		auto listeners = Listeners.Get("BeforeCharacterApplyDamage");
+		if (listeners == nullptr) return false;
+
 		Restriction restriction(*this, RestrictOsiris);
 
-		PushExtFunction(L, "_BeforeCharacterApplyDamage"); // stack: fn
+		// Listeners update the same hit table, which is read back after all of them were called
+		PushHit(L, hit); // stack: hit
+		auto hitIndex = lua_gettop(L);
 
 		auto luaTarget = ObjectProxy<esv::Character>::New(L, target);
 		UnbindablePin _(luaTarget);
@@ -1247,16 +1290,11 @@ namespace dse::esv::lua
 
 		ItemOrCharacterPushPin luaAttacker(L, attacker);
 
-		PushHit(L, hit);
-
+		lua_pushvalue(L, hitIndex);
 		push(L, causeType);
-		push(L, impactDirection); // stack: fn, target, attacker, hit, causeType, impactDirection
+		push(L, impactDirection); // stack: hit, target, attacker, hit, causeType, impactDirection
 
-		if (CallWithTraceback(L, 5, 1) != 0) { // stack: succeeded
-			OsiError("BeforeCharacterApplyDamage handler failed: " << lua_tostring(L, -1));
-			lua_pop(L, 1);
-			return false;
-		}
+		CallListeners(L, *listeners, "BeforeCharacterApplyDamage", 5, 0); // stack: hit
 
 		int top = lua_gettop(L);
 		try {
@@ -1275,6 +1313,9 @@ namespace dse::esv::lua
 	bool ServerState::OnUpdateTurnOrder(esv::TurnManager * self, uint8_t combatId)
 	{
 		std::lock_guard lock(mutex_);
+		auto listeners = Listeners.Get("CalculateTurnOrder");
+		if (listeners == nullptr) return false;
+
 		Restriction restriction(*this, RestrictOsiris);
 
 		auto turnMgr = GetEntityWorld()->GetTurnManager();
@@ -1289,27 +1330,19 @@ namespace dse::esv::lua
 			return false;
 		}
 
-		PushExtFunction(L, "_CalculateTurnOrder"); // stack: fn
-
-		TurnManagerCombatProxy::New(L, combatId); // stack: fn, combat
+		TurnManagerCombatProxy::New(L, combatId); // stack: combat
 		CombatTeamListToLua(L, combat->NextRoundTeams.Set);
 
-		if (CallWithTraceback(L, 2, 1) != 0) { // stack: retval
-			OsiError("OnUpdateTurnOrder handler failed: " << lua_tostring(L, -1));
-			lua_pop(L, 1);
+		if (!CallListeners(L, *listeners, "CalculateTurnOrder", 2, 1)) { // stack: retval
 			return false;
 		}
 
-		int isnil = lua_isnil(L, -1);
-
 		bool ok = false;
-		if (!isnil) {
-			try {
-				UpdateTurnOrder(L, combatId, -1, combat->NextRoundTeams, combat->NextTurnChangeNotificationTeamIds);
-				ok = true;
-			} catch (Exception &) {
-				OsiError("UpdateTurnOrder failed");
-			}
+		try {
+			UpdateTurnOrder(L, combatId, -1, combat->NextRoundTeams, combat->NextTurnChangeNotificationTeamIds);
+			ok = true;
+		} catch (Exception &) {
+			OsiError("UpdateTurnOrder failed");
 		}
 
 		lua_pop(L, 1); // stack: -
@@ -1,42 +1,6 @@
-Ext._Listeners = {
-	ModuleLoadStarted = {},
-	ModuleLoading = {},
-	StatsLoaded = {},
-	ModuleResume = {},
-	SessionLoading = {},
-	SessionLoaded = {},
-	SkillGetDescriptionParam = {},
-	StatusGetDescriptionParam = {},
-	GetSkillDamage = {},
-	GetHitChance = {},
-	UIInvoke = {},
-	UICall = {}
-}
-
-Ext._SkillGetDescriptionParam = function (...)
-    return Ext._EngineCallback1("SkillGetDescriptionParam", ...)
-end
-
-Ext._StatusGetDescriptionParam = function (...)
-    return Ext._EngineCallback1("StatusGetDescriptionParam", ...)
-end
-
-Ext._GetSkillDamage = function (...)
-    for i,callback in pairs(Ext._Listeners.GetSkillDamage) do
-        local status, damageList, deathType = xpcall(callback, debug.traceback, ...)
-        if status then
-			if damageList ~= nil then
-				return damageList, deathType
-			end
-		else
-            Ext.PrintError("Error during GetSkillDamage: ", damageList)
-        end
-    end
-end
-
 Ext.RegisterListener = function (type, fn)
-	if Ext._Listeners[type] ~= nil then
-		table.insert(Ext._Listeners[type], fn)
+	if Ext._RegisterListener(type, fn) then
+		return
 	elseif type == "CalculateTurnOrder" or type == "ComputeCharacterHit" or type == "StatusGetEnterChance" then
 		Ext._WarnDeprecated("Cannot register listeners for event '" .. type .. "' from client!")
 	else
@@ -91,6 +55,7 @@ Ext.RegisterUICall = function (object, call, fn)
 	end
 	
 	table.insert(Ext._UIExternalInterfaceHandleListeners[handle][call], fn)
+	Ext._RegisterUICallName(call)
 	object:CaptureExternalInterfaceCalls()
 end
 
@@ -104,6 +69,7 @@ Ext.RegisterUITypeCall = function (typeId, call, fn)
 	end
 	
 	table.insert(Ext._UIExternalInterfaceTypeListeners[typeId][call], fn)
+	Ext._RegisterUICallName(call)
 end
 
 Ext.RegisterUINameCall = function (call, fn)
@@ -112,6 +78,7 @@ Ext.RegisterUINameCall = function (call, fn)
 	end
 	
 	table.insert(Ext._UIExternalInterfaceNameListeners[call], fn)
+	Ext._RegisterUICallName(call)
 end
 
 Ext._UICall = function (object, call, ...)
@@ -163,6 +130,7 @@ Ext.RegisterUIInvokeListener = function (object, method, fn)
 	end
 	
 	table.insert(Ext._UIInvokeHandleListeners[handle][method], fn)
+	Ext._RegisterUIInvokeName(method)
 	object:CaptureInvokes()
 end
 
@@ -176,6 +144,7 @@ Ext.RegisterUITypeInvokeListener = function (typeId, method, fn)
 	end
 	
 	table.insert(Ext._UIInvokeTypeListeners[typeId][method], fn)
+	Ext._RegisterUIInvokeName(method)
 end
 
 Ext.RegisterUINameInvokeListener = function (method, fn)
@@ -184,6 +153,7 @@ Ext.RegisterUINameInvokeListener = function (method, fn)
 	end
 	
 	table.insert(Ext._UIInvokeNameListeners[method], fn)
+	Ext._RegisterUIInvokeName(method)
 end
 
 Ext._UIInvoke = function (object, method, ...)
@@ -1,46 +1,6 @@
-Ext._Listeners = {
-	ModuleLoadStarted = {},
-	ModuleLoading = {},
-	StatsLoaded = {},
-	ModuleResume = {},
-	SessionLoading = {},
-	SessionLoaded = {},
-	GetSkillDamage = {},
-	ComputeCharacterHit = {},
-	CalculateTurnOrder = {},
-	GetHitChance = {},
-	StatusGetEnterChance = {},
-	BeforeCharacterApplyDamage = {}
-}
-
-Ext._GetSkillDamage = function (...)
-    for i,callback in pairs(Ext._Listeners.GetSkillDamage) do
-        local status, damageList, deathType = xpcall(callback, debug.traceback, ...)
-        if status then
-			if damageList ~= nil then
-				return damageList, deathType
-			end
-		else
-            Ext.PrintError("Error during GetSkillDamage: ", damageList)
-        end
-    end
-end
-
-Ext._ComputeCharacterHit = function (...)
-    return Ext._EngineCallback1("ComputeCharacterHit", ...)
-end
-
-Ext._CalculateTurnOrder = function (...)
-    return Ext._EngineCallback1("CalculateTurnOrder", ...)
-end
-
-Ext._StatusGetEnterChance = function (...)
-    return Ext._EngineCallback1("StatusGetEnterChance", ...)
-end
-
 Ext.RegisterListener = function (type, fn)
-	if Ext._Listeners[type] ~= nil then
-		table.insert(Ext._Listeners[type], fn)
+	if Ext._RegisterListener(type, fn) then
+		return
 	elseif type == "SkillGetDescriptionParam" or type == "StatusGetDescriptionParam" then
 		Ext._WarnDeprecated("Cannot register listeners for event '" .. type .. "' from server!")
 	else
@@ -80,14 +40,3 @@ Ext._RestoreModPersistentVars = function (modTable, vars)
 		tab.PersistentVars = Ext.JsonParse(vars)
 	end
 end
-
-Ext._BeforeCharacterApplyDamage = function (target, attacker, hit, causeType, impactDirection)
-    for i,callback in pairs(Ext._Listeners.BeforeCharacterApplyDamage) do
-        local status, result = xpcall(callback, debug.traceback, target, attacker, hit, causeType, impactDirection)
-        if not status then
-            Ext.PrintError("Error during BeforeCharacterApplyDamage: ", result)
-        end
-    end
-
-	return hit
-end
@@ -41,9 +41,7 @@ function IsRangedWeapon(item)
 end
 
 --- @param primaryAttr integer
-function ScaledDamageFromPrimaryAttribute(primaryAttr)
-    return (primaryAttr - Ext.ExtraData.AttributeBaseValue) * Ext.ExtraData.DamageBoostFromAttribute
-end
+ScaledDamageFromPrimaryAttribute = Ext._NativeMath.ScaledDamageFromPrimaryAttribute
 
 --- @param skill StatEntrySkillData
 --- @param character StatCharacter
@@ -100,55 +98,19 @@ function GetDamageMultipliers(skill, stealthed, attackerPos, targetPos)
 end
 
 --- @param level integer
-function GetVitalityBoostByLevel(level)
-    local extra = Ext.ExtraData
-    local expGrowth = extra.VitalityExponentialGrowth
-    local growth = expGrowth ^ (level - 1)
-
-    if level >= extra.FirstVitalityLeapLevel then
-        growth = growth * extra.FirstVitalityLeapGrowth / expGrowth
-    end
-
-    if level >= extra.SecondVitalityLeapLevel then
-        growth = growth * extra.SecondVitalityLeapGrowth / expGrowth
-    end
-
-    if level >= extra.ThirdVitalityLeapLevel then
-        growth = growth * extra.ThirdVitalityLeapGrowth / expGrowth
-    end
-
-    if level >= extra.FourthVitalityLeapLevel then
-        growth = growth * extra.FourthVitalityLeapGrowth / expGrowth
-    end
-
-    local vit = level * extra.VitalityLinearGrowth + extra.VitalityStartingAmount * growth
-    return Ext.Round(vit / 5.0) * 5.0
-end
+GetVitalityBoostByLevel = Ext._NativeMath.GetVitalityBoostByLevel
 
 --- @param level integer
-function GetLevelScaledDamage(level)
-    local vitalityBoost = GetVitalityBoostByLevel(level)
-    return vitalityBoost / (((level - 1) * Ext.ExtraData.VitalityToDamageRatioGrowth) + Ext.ExtraData.VitalityToDamageRatio)
-end
+GetLevelScaledDamage = Ext._NativeMath.GetLevelScaledDamage
 
 --- @param level integer
-function GetAverageLevelDamage(level)
-    local scaled = GetLevelScaledDamage(level)
-    return ((level * Ext.ExtraData.ExpectedDamageBoostFromAttributePerLevel) + 1.0) * scaled
-        * ((level * Ext.ExtraData.ExpectedDamageBoostFromSkillAbilityPerLevel) + 1.0)
-end
+GetAverageLevelDamage = Ext._NativeMath.GetAverageLevelDamage
 
 --- @param level integer
-function GetLevelScaledWeaponDamage(level)
-    local scaledDmg = GetLevelScaledDamage(level)
-    return scaledDmg / ((level * Ext.ExtraData.ExpectedDamageBoostFromWeaponAbilityPerLevel) + 1.0)
-end
+GetLevelScaledWeaponDamage = Ext._NativeMath.GetLevelScaledWeaponDamage
 
 --- @param level integer
-function GetLevelScaledMonsterWeaponDamage(level)
-    local weaponDmg = GetLevelScaledWeaponDamage(level)
-    return ((level * Ext.ExtraData.MonsterDamageBoostPerLevel) + 1.0) * weaponDmg
-end
+GetLevelScaledMonsterWeaponDamage = Ext._NativeMath.GetLevelScaledMonsterWeaponDamage
 
 --- @param attacker StatCharacter
 function GetShieldPhysicalArmor(attacker)
@@ -658,74 +620,20 @@ HitFlag = {
 
 --- @param damageList DamageList
 --- @param attacker StatCharacter
-function ApplyDamageSkillAbilityBonuses(damageList, attacker)
-
-    if attacker == nil then
-        return
-     end
- 
-     local magicArmorDamage = 0
-     local armorDamage = 0
- 
-     for i,damage in pairs(damageList:ToTable()) do
-         local type = damage.DamageType
-         if type == "Magic" or type == "Fire" or type == "Air" or type == "Water" or type == "Earth" then
-             magicArmorDamage = magicArmorDamage + damage.Amount
-         end
- 
-         if type == "Physical" or type == "Corrosive" or type == "Sulfuric" then
-             armorDamage = armorDamage + damage.Amount
-         end
-     end
-   
-     if magicArmorDamage > 0 then
-         local airSpecialist = attacker.AirSpecialist
-         if airSpecialist > 0 then
-             local magicBonus = airSpecialist * Ext.ExtraData.SkillAbilityDamageToMagicArmorPerPoint
-             if magicBonus > 0 then
-                 magicArmorDamage = math.ceil((magicArmorDamage * magicBonus) / 100.0)
-                 damageList:Add("Magic", magicArmorDamage)
-             end
-         end
-     end
-   
-     if armorDamage > 0 then
-         local armorBonus = attacker.WarriorLore * Ext.ExtraData.SkillAbilityDamageToPhysicalArmorPerPoint
-         if armorBonus > 0 then
-             armorDamage = math.ceil((armorDamage * armorBonus) / 100.0)
-             damageList:Add("Corrosive", armorDamage)
-         end
-     end
-end
+ApplyDamageSkillAbilityBonuses = Ext._NativeMath.ApplyDamageSkillAbilityBonuses
 
 --- @param character StatCharacter
 --- @param type string DamageType enumeration
-function GetResistance(character, type)
-    if type == "None" or type == "Chaos" then
-        return 0
-    end
-
-    return character[type .. "Resistance"]
-end
+GetResistance = Ext._NativeMath.GetResistance
 
 --- @param character StatCharacter
 --- @param damageList DamageList
-function ApplyHitResistances(character, damageList)
-    for i,damage in pairs(damageList:ToTable()) do
-        local resistance = GetResistance(character, damage.DamageType)
-        damageList:Add(damage.DamageType, math.floor(damage.Amount * -resistance / 100.0))
-    end
-end
+ApplyHitResistances = Ext._NativeMath.ApplyHitResistances
 
 --- @param character StatCharacter
 --- @param attacker StatCharacter
 --- @param damageList DamageList
-function ApplyDamageCharacterBonuses(character, attacker, damageList)
-    damageList:AggregateSameTypeDamages()
-    ApplyHitResistances(character, damageList)
-
-    ApplyDamageSkillAbilityBonuses(damageList, attacker)
-end
+ApplyDamageCharacterBonuses = Ext._NativeMath.ApplyDamageCharacterBonuses
 
 
 --- @param character StatCharacter
@@ -985,22 +893,7 @@ end
 
 --- @param attacker StatCharacter
 --- @param target StatCharacter
-function CalculateHitChance(attacker, target)
-    if attacker.TALENT_Haymaker then
-        return 100
-    end
-
-    local ranged = IsRangedWeapon(attacker.MainWeapon.WeaponType)
-    local accuracy = attacker.Accuracy
-    local dodge = 0
-    if (not attacker.Invisible or ranged) and target.IsIncapacitatedRefCount == 0 then
-        dodge = target.Dodge
-    end
-
-    local chanceToHit1 = Ext.Round(((100.0 - dodge) * accuracy) / 100)
-    chanceToHit1 = math.max(0, math.min(100, chanceToHit1))
-    return chanceToHit1 + attacker.ChanceToHitBoost
-end
+CalculateHitChance = Ext._NativeMath.CalculateHitChance
 
 --- @param target StatCharacter
 --- @param attacker StatCharacter
@@ -582,7 +582,12 @@ local StatCharacter = {
     --- @param self StatCharacter
     --- @param slot string See Itemslot enumeration
     --- @return StatItem|nil
-    GetItemBySlot = function (self, slot) end
+    GetItemBySlot = function (self, slot) end,
+    --- Returns the values of the specified stats in a table keyed by stat name
+    --- @param self StatCharacter
+    --- @param names string[] Stat names
+    --- @return table
+    GetProperties = function (self, names) end
 }
 
 
@@ -908,6 +913,11 @@ local EsvCharacter = {
     --- @param self EsvCharacter
     --- @return string[]
     GetInventoryItems = function (self) end,
+    --- Returns the values of the specified properties in a table keyed by property name
+    --- @param self EsvCharacter
+    --- @param names string[] Property names
+    --- @return table
+    GetProperties = function (self, names) end,
     --- Returns whether the character has the specified tag
     --- @param self EsvCharacter
     --- @param tag string
@@ -2322,6 +2332,20 @@ Ext = {
     --- @param arguments string Query argument list
     NewQuery = function (func, funcName, arguments) end,
 
+    --- Marks a DIV query as side-effect free; results of the query are reused
+    --- when it is called with the same arguments within the same Osiris callback
+    --- @param funcName string Name of query
+    MemoizeOsiQuery = function (funcName) end,
+
+    --- Returns the hit/miss counters of the memoized query cache
+    --- @return table {Hits: integer, Misses: integer}
+    GetOsiQueryCacheStats = function () end,
+
+    --- Replays the story inputs recorded in a binary Osiris trace against the current story
+    --- @param fileName string Trace file name (relative to the Osiris Data directory)
+    --- @return table {Events: integer, Inserts: integer, Deletes: integer, Skipped: integer, Time: number}
+    ReplayOsirisTrace = function (fileName) end,
+
     --- Registers a new event in Osiris
     --- @param funcName string Name of event to register
     --- @param arguments string Event argument list
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "NodeHooks.h"
+#include "OsirisTracer.h"
 #include <sstream>
 #include <memory>
 #include <cassert>
@@ -32,6 +33,16 @@ namespace dse
 		: vmt_(vmt), options_(options)
 	{
 		originalVmt_ = *vmt_;
+	}
+
+	NodeVMTWrapper::~NodeVMTWrapper()
+	{
+		Uninstall();
+	}
+
+	void NodeVMTWrapper::Install()
+	{
+		if (installed_) return;
 
 		ROWriteAnchor<NodeVMT> _(vmt_);
 		if (options_.WrapIsValid) {
@@ -57,12 +68,17 @@ namespace dse
 		if (options_.WrapCallQuery) {
 			vmt_->CallQuery = &s_WrappedCallQuery;
 		}
+
+		installed_ = true;
 	}
 
-	NodeVMTWrapper::~NodeVMTWrapper()
+	void NodeVMTWrapper::Uninstall()
 	{
+		if (!installed_) return;
+
 		ROWriteAnchor<NodeVMT> _(vmt_);
 		*vmt_ = originalVmt_;
+		installed_ = false;
 	}
 
 	bool NodeVMTWrapper::WrappedIsValid(Node * node, VirtTupleLL * tuple, AdapterRef * adapter)
@@ -147,6 +163,30 @@ namespace dse
 		}
 	}
 
+	void NodeVMTWrappers::InstallHooks()
+	{
+		if (hooksInstalled_) return;
+
+		DEBUG("NodeVMTWrappers::InstallHooks()");
+		for (unsigned i = 1; i < (unsigned)NodeType::Max + 1; i++) {
+			wrappers_[i]->Install();
+		}
+
+		hooksInstalled_ = true;
+	}
+
+	void NodeVMTWrappers::UninstallHooks()
+	{
+		if (!hooksInstalled_) return;
+
+		DEBUG("NodeVMTWrappers::UninstallHooks()");
+		for (unsigned i = 1; i < (unsigned)NodeType::Max + 1; i++) {
+			wrappers_[i]->Uninstall();
+		}
+
+		hooksInstalled_ = false;
+	}
+
 	NodeType NodeVMTWrappers::GetType(Node * node)
 	{
 		NodeVMT * vfptr = *reinterpret_cast<NodeVMT **>(node);
@@ -170,6 +210,10 @@ namespace dse
 			IsValidPreHook(node, tuple, adapter);
 		}
 
+		if (Tracer) {
+			Tracer->Trace(TraceEventType::IsValid, node, tuple->Data);
+		}
+
 		bool succeeded = wrapper.WrappedIsValid(node, tuple, adapter);
 
 		if (IsValidPostHook) {
@@ -187,6 +231,10 @@ namespace dse
 			PushDownPreHook(node, tuple, adapter, which, false);
 		}
 
+		if (Tracer) {
+			Tracer->Trace(TraceEventType::PushDown, node, tuple->Data);
+		}
+
 		wrapper.WrappedPushDownTuple(node, tuple, adapter, which);
 
 		if (PushDownPostHook) {
@@ -202,6 +250,10 @@ namespace dse
 			PushDownPreHook(node, tuple, adapter, which, true);
 		}
 
+		if (Tracer) {
+			Tracer->Trace(TraceEventType::PushDownDelete, node, tuple->Data);
+		}
+
 		wrapper.WrappedPushDownTupleDelete(node, tuple, adapter, which);
 
 		if (PushDownPostHook) {
@@ -217,6 +269,10 @@ namespace dse
 			InsertPreHook(node, tuple, false);
 		}
 
+		if (Tracer) {
+			Tracer->Trace(TraceEventType::Insert, node, *tuple);
+		}
+
 		wrapper.WrappedInsertTuple(node, tuple);
 
 		if (InsertPostHook) {
@@ -232,6 +288,10 @@ namespace dse
 			InsertPreHook(node, tuple, true);
 		}
 
+		if (Tracer) {
+			Tracer->Trace(TraceEventType::Delete, node, *tuple);
+		}
+
 		wrapper.WrappedDeleteTuple(node, tuple);
 
 		if (InsertPostHook) {
@@ -247,6 +307,10 @@ namespace dse
 			CallQueryPreHook(node, args);
 		}
 
+		if (Tracer) {
+			Tracer->Trace(TraceEventType::CallQuery, node, args);
+		}
+
 		bool succeeded = wrapper.WrappedCallQuery(node, args);
 
 		if (CallQueryPostHook) {
@@ -6,6 +6,8 @@
 
 namespace dse
 {
+	class OsirisTracer;
+
 	struct NodeWrapOptions
 	{
 		bool WrapIsValid;
@@ -22,6 +24,9 @@ namespace dse
 		NodeVMTWrapper(NodeVMT * vmt, NodeWrapOptions & options);
 		~NodeVMTWrapper();
 
+		void Install();
+		void Uninstall();
+
 		bool WrappedIsValid(Node * node, VirtTupleLL * tuple, AdapterRef * adapter);
 		void WrappedPushDownTuple(Node * node, VirtTupleLL * tuple, AdapterRef * adapter, EntryPoint which);
 		void WrappedPushDownTupleDelete(Node * node, VirtTupleLL * tuple, AdapterRef * adapter, EntryPoint which);
@@ -33,6 +38,7 @@ namespace dse
 		NodeVMT * vmt_;
 		NodeWrapOptions & options_;
 		NodeVMT originalVmt_;
+		bool installed_{ false };
 
 		static bool s_WrappedIsValid(Node * node, VirtTupleLL * tuple, AdapterRef * adapter);
 		static void s_WrappedPushDownTuple(Node * node, VirtTupleLL * tuple, AdapterRef * adapter, EntryPoint which);
@@ -47,6 +53,16 @@ namespace dse
 	public:
 		NodeVMTWrappers(NodeVMT ** vmts);
 
+		// Patch/restore the node VMTs.
+		// These must only be called when no story code is executing (i.e. no wrapped call is on the stack)
+		void InstallHooks();
+		void UninstallHooks();
+
+		inline bool HooksInstalled() const
+		{
+			return hooksInstalled_;
+		}
+
 		bool WrappedIsValid(Node * node, VirtTupleLL * tuple, AdapterRef * adapter);
 		void WrappedPushDownTuple(Node * node, VirtTupleLL * tuple, AdapterRef * adapter, EntryPoint which);
 		void WrappedPushDownTupleDelete(Node * node, VirtTupleLL * tuple, AdapterRef * adapter, EntryPoint which);
@@ -62,6 +78,8 @@ namespace dse
 		std::function<void (Node *, TuplePtrLL *, bool)> InsertPostHook;
 		std::function<void(Node *, OsiArgumentDesc *)> CallQueryPreHook;
 		std::function<void(Node *, OsiArgumentDesc *, bool)> CallQueryPostHook;
+		// Binary trace log; called before each wrapped node method
+		OsirisTracer * Tracer{ nullptr };
 
 		NodeType GetType(Node * node);
 		NodeVMTWrapper & GetWrapper(Node * node);
@@ -70,6 +88,7 @@ namespace dse
 		NodeVMT ** vmts_;
 		std::unique_ptr<NodeVMTWrapper> wrappers_[(unsigned)NodeType::Max + 1];
 		std::unordered_map<NodeVMT *, NodeType> vmtToTypeMap_;
+		bool hooksInstalled_{ false };
 	};
 
 	extern std::unique_ptr<NodeVMTWrappers> gNodeVMTWrappers;
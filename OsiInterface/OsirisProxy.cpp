@@ -67,9 +67,16 @@ void OsirisProxy::Initialize()
 	Wrappers.Compile.SetWrapper(std::bind(&OsirisProxy::CompileWrapper, this, _1, _2, _3, _4));
 	Wrappers.Load.AddPostHook(std::bind(&OsirisProxy::OnAfterOsirisLoad, this, _1, _2, _3));
 	Wrappers.Merge.SetWrapper(std::bind(&OsirisProxy::MergeWrapper, this, _1, _2, _3));
-#if !defined(OSI_NO_DEBUGGER)
-	Wrappers.RuleActionCall.SetWrapper(std::bind(&OsirisProxy::RuleActionCall, this, _1, _2, _3, _4, _5, _6));
-#endif
+	// The story call depth is needed by the debugger and the binary tracer
+	if (config_.EnableDebugger || (config_.EnableLogging && config_.BinaryLogging)) {
+		Wrappers.RuleActionCall.SetWrapper(std::bind(&OsirisProxy::RuleActionCall, this, _1, _2, _3, _4, _5, _6));
+		Wrappers.Event.AddPreHook(std::bind(&OsirisProxy::OnOsirisEvent, this, _1, _2, _3));
+		Wrappers.Event.AddPostHook(std::bind(&OsirisProxy::OnAfterOsirisEvent, this, _1, _2, _3, _4));
+	}
+
+	if (extensionsEnabled_ && config_.EnableLuaBytecodeCache) {
+		luaBytecodeCache_ = std::make_unique<lua::BytecodeCache>(config_.LogDirectory);
+	}
 
 	if (Libraries.FindLibraries()) {
 		if (extensionsEnabled_) {
@@ -112,6 +119,10 @@ void OsirisProxy::Shutdown()
 	DEBUG("OsirisProxy::Shutdown: Exiting");
 	ResetExtensionStateServer();
 	ResetExtensionStateClient();
+	if (gNodeVMTWrappers) {
+		gNodeVMTWrappers->Tracer = nullptr;
+	}
+	tracer_.reset();
 	Wrappers.Shutdown();
 }
 
@@ -198,9 +209,36 @@ std::wstring OsirisProxy::MakeLogFilePath(std::wstring const & Type, std::wstrin
 
 void OsirisProxy::HookNodeVMTs()
 {
+	// Wrappers are installed on demand by UpdateNodeHooks()
 	gNodeVMTWrappers = std::make_unique<NodeVMTWrappers>(NodeVMTs);
 }
 
+void OsirisProxy::UpdateNodeHooks()
+{
+	if (!gNodeVMTWrappers) return;
+
+	bool needsNodeHooks = (tracer_ != nullptr);
+
+#if !defined(OSI_NO_DEBUGGER)
+	if (debugger_) {
+		// Only pay for the debugger hooks while a debugger frontend is connected
+		if (debugMsgHandler_->IsConnected()) {
+			debugger_->Attach();
+		} else {
+			debugger_->Detach();
+		}
+
+		needsNodeHooks = needsNodeHooks || debugger_->IsAttached();
+	}
+#endif
+
+	if (needsNodeHooks) {
+		gNodeVMTWrappers->InstallHooks();
+	} else {
+		gNodeVMTWrappers->UninstallHooks();
+	}
+}
+
 #if !defined(OSI_NO_DEBUGGER)
 void DebugThreadRunner(DebugInterface & intf)
 {
@@ -255,7 +293,17 @@ void OsirisProxy::OnRegisterDIVFunctions(void * Osiris, DivFunctions * Functions
 	}
 
 	if (config_.EnableLogging) {
-		RestartLogging(L"Runtime");
+		if (config_.BinaryLogging) {
+			// Each story gets its own trace file, as node IDs and function handles are only valid
+			// within one story. The trace is started after the story was loaded (see OnAfterOsirisLoad).
+			if (gNodeVMTWrappers) {
+				gNodeVMTWrappers->Tracer = nullptr;
+			}
+
+			tracer_ = std::make_unique<OsirisTracer>(MakeLogFilePath(L"Runtime", L"ositrace"));
+		} else {
+			RestartLogging(L"Runtime");
+		}
 	}
 
 #if 0
@@ -271,7 +319,10 @@ void OsirisProxy::OnRegisterDIVFunctions(void * Osiris, DivFunctions * Functions
 		if (DebuggerThread == nullptr) {
 			DEBUG("Starting debugger server");
 			try {
-				debugInterface_ = std::make_unique<DebugInterface>(config_.DebuggerPort);
+				DebugBatchConfig batchConfig;
+				batchConfig.MaxBytes = config_.DebuggerBatchSize;
+				batchConfig.FlushIntervalMs = config_.DebuggerFlushInterval;
+				debugInterface_ = std::make_unique<DebugInterface>(config_.DebuggerPort, batchConfig);
 				debugMsgHandler_ = std::make_unique<DebugMessageHandler>(std::ref(*debugInterface_));
 				DebuggerThread = new std::thread(std::bind(DebugThreadRunner, std::ref(*debugInterface_)));
 			} catch (std::exception & e) {
@@ -302,6 +353,7 @@ void OsirisProxy::OnDeleteAllData(void * Osiris, bool DeleteTypes)
 		DEBUG("OsirisProxy::OnDeleteAllData()");
 		debugger_->DeleteAllDataHook();
 		debugger_.reset();
+		UpdateNodeHooks();
 	}
 #endif
 }
@@ -360,13 +412,24 @@ void OsirisProxy::OnAfterOsirisLoad(void * Osiris, void * Buf, int retval)
 {
 	std::lock_guard _(storyLoadLock_);
 
+	if (tracer_ && !tracer_->Start(ComputeTraceStoryId(Wrappers.Globals))) {
+		tracer_.reset();
+	}
+
+	bool needsNodeHooks = (tracer_ != nullptr);
 #if !defined(OSI_NO_DEBUGGER)
-	if (DebuggerThread != nullptr && !ResolvedNodeVMTs) {
+	needsNodeHooks = needsNodeHooks || (DebuggerThread != nullptr);
+#endif
+
+	if (needsNodeHooks && !ResolvedNodeVMTs) {
 		ResolveNodeVMTs(*Wrappers.Globals.Nodes);
 		ResolvedNodeVMTs = true;
 		HookNodeVMTs();
 	}
-#endif
+
+	if (gNodeVMTWrappers) {
+		gNodeVMTWrappers->Tracer = tracer_.get();
+	}
 
 	StoryLoaded = true; 
 	DEBUG("OsirisProxy::OnAfterOsirisLoad: %d nodes", (*Wrappers.Globals.Nodes)->Db.Size);
@@ -375,8 +438,13 @@ void OsirisProxy::OnAfterOsirisLoad(void * Osiris, void * Buf, int retval)
 	if (DebuggerThread != nullptr && gNodeVMTWrappers) {
 		debugger_.reset();
 		debugger_ = std::make_unique<Debugger>(Wrappers.Globals, std::ref(*debugMsgHandler_));
+		UpdateNodeHooks();
 		debugger_->StoryLoaded();
+	} else {
+		UpdateNodeHooks();
 	}
+#else
+	UpdateNodeHooks();
 #endif
 
 	if (extensionsEnabled_) {
@@ -474,19 +542,44 @@ bool OsirisProxy::MergeWrapper(std::function<bool (void *, wchar_t *)> const & N
 
 void OsirisProxy::RuleActionCall(std::function<void (RuleActionNode *, void *, void *, void *, void *)> const & Next, RuleActionNode * Action, void * a1, void * a2, void * a3, void * a4)
 {
+	storyCallDepth_++;
 #if !defined(OSI_NO_DEBUGGER)
-	if (debugger_ != nullptr) {
+	if (debugger_ != nullptr && debugger_->IsAttached()) {
 		debugger_->RuleActionPreHook(Action);
+		Next(Action, a1, a2, a3, a4);
+		debugger_->RuleActionPostHook(Action);
+	} else {
+		Next(Action, a1, a2, a3, a4);
 	}
+#else
+	Next(Action, a1, a2, a3, a4);
 #endif
+	storyCallDepth_--;
+}
 
-	Next(Action, a1, a2, a3, a4);
+void OsirisProxy::OnOsirisEvent(void * Osiris, uint32_t FunctionId, OsiArgumentDesc * Args)
+{
+	if (storyCallDepth_++ == 0) {
+		// Events thrown by the engine are the only story-idle points where the node VMTs can be safely (un)patched
+		UpdateNodeHooks();
 
-#if !defined(OSI_NO_DEBUGGER)
-	if (debugger_ != nullptr) {
-		debugger_->RuleActionPostHook(Action);
+		if (tracer_) {
+			tracer_->TraceInput(FunctionId, Args);
+		}
+	}
+}
+
+void OsirisProxy::OnAfterOsirisEvent(void * Osiris, uint32_t FunctionId, OsiArgumentDesc * Args, ReturnCode retval)
+{
+	storyCallDepth_--;
+}
+
+void OsirisProxy::TraceStoryInsert(Node * node, TuplePtrLL const & tuple, bool deleted)
+{
+	// Inserts made while story code is running are replayed by replaying the outermost event
+	if (tracer_ && storyCallDepth_ == 0) {
+		tracer_->TraceInput(deleted ? TraceInputType::Delete : TraceInputType::Insert, node, tuple);
 	}
-#endif
 }
 
 void OsirisProxy::SaveNodeVMT(NodeType type, NodeVMT * vmt)
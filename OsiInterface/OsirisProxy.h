@@ -9,7 +9,9 @@
 #include "Debugger.h"
 #endif
 #include "OsirisWrappers.h"
+#include "OsirisTracer.h"
 #include "CustomFunctions.h"
+#include "Lua/LuaBytecodeCache.h"
 #include "DataLibraries.h"
 #include "Functions/FunctionLibrary.h"
 #include "NetProtocol.h"
@@ -28,12 +30,14 @@ struct ToolConfig
 #if defined(OSI_EXTENSION_BUILD)
 	bool CreateConsole{ false };
 	bool EnableLogging{ false };
+	bool BinaryLogging{ false };
 	bool LogCompile{ false };
 	bool EnableExtensions{ true };
 	bool EnableDebugger{ false };
 #else
 	bool CreateConsole{ true };
 	bool EnableLogging{ false };
+	bool BinaryLogging{ false };
 	bool LogCompile{ false };
 	bool EnableExtensions{ true };
 	bool EnableDebugger{ true };
@@ -41,6 +45,7 @@ struct ToolConfig
 
 	bool SendCrashReports{ true };
 	bool EnableAchievements{ true };
+	bool EnableLuaBytecodeCache{ false };
 
 #if defined(OSI_EXTENSION_BUILD)
 	bool DisableModValidation{ true };
@@ -61,6 +66,8 @@ struct ToolConfig
 	bool SyncNetworkStrings{ false };
 #endif
 	uint16_t DebuggerPort{ 9999 };
+	uint32_t DebuggerBatchSize{ 0x10000 };
+	uint32_t DebuggerFlushInterval{ 5 };
 	uint32_t DebugFlags{ 0 };
 	std::wstring LogDirectory;
 };
@@ -119,6 +126,11 @@ public:
 		return config_;
 	}
 
+	inline lua::BytecodeCache * GetLuaBytecodeCache()
+	{
+		return luaBytecodeCache_.get();
+	}
+
 	void LogOsirisError(std::string_view msg);
 	void LogOsirisWarning(std::string_view msg);
 	void LogOsirisMsg(std::string_view msg);
@@ -160,6 +172,31 @@ public:
 
 	ExtensionStateBase* GetCurrentExtensionState();
 
+	// Records a database insert/delete made by the extender if a binary trace is being written
+	void TraceStoryInsert(Node * node, TuplePtrLL const & tuple, bool deleted);
+
+	// Story code that is started from outside of Osiris (eg. from Lua) must be wrapped
+	// in a StoryCallScope, so node hooks are not (un)patched while it is running
+	inline void EnterStoryCall()
+	{
+		storyCallDepth_++;
+	}
+
+	inline void ExitStoryCall()
+	{
+		storyCallDepth_--;
+	}
+
+	inline bool IsTracingStory() const
+	{
+		return tracer_ != nullptr;
+	}
+
+	inline bool IsStoryLoaded() const
+	{
+		return StoryLoaded;
+	}
+
 	inline bool HasServerExtensionState() const
 	{
 		return (bool)ServerExtState;
@@ -261,6 +298,8 @@ private:
 	void OnAfterOsirisLoad(void * Osiris, void * Buf, int retval);
 	bool MergeWrapper(std::function<bool(void *, wchar_t *)> const & Next, void * Osiris, wchar_t * Src);
 	void RuleActionCall(std::function<void(RuleActionNode *, void *, void *, void *, void *)> const & Next, RuleActionNode * Action, void * a1, void * a2, void * a3, void * a4);
+	void OnOsirisEvent(void * Osiris, uint32_t FunctionId, OsiArgumentDesc * Args);
+	void OnAfterOsirisEvent(void * Osiris, uint32_t FunctionId, OsiArgumentDesc * Args, ReturnCode retval);
 
 	ToolConfig config_;
 	bool extensionsEnabled_{ false };
@@ -268,6 +307,8 @@ private:
 
 	std::wstring LogFilename;
 	std::wstring LogType;
+	std::unique_ptr<OsirisTracer> tracer_;
+	std::unique_ptr<lua::BytecodeCache> luaBytecodeCache_;
 
 	bool StoryLoaded{ false };
 	std::recursive_mutex storyLoadLock_;
@@ -279,10 +320,15 @@ private:
 	std::unique_ptr<Debugger> debugger_;
 	bool DebugDisableLogged{ false };
 #endif
+	// Nesting level of Osiris events, rule actions and extender-initiated story calls;
+	// node hooks are only updated and story inputs are only traced at depth 0
+	// (i.e. when no story code is running)
+	uint32_t storyCallDepth_{ 0 };
 
 	void ResolveNodeVMTs(NodeDb * Db);
 	void SaveNodeVMT(NodeType type, NodeVMT * vmt);
 	void HookNodeVMTs();
+	void UpdateNodeHooks();
 	void RestartLogging(std::wstring const & Type);
 
 	void OnBaseModuleLoaded(void * self);
@@ -314,4 +360,18 @@ private:
 
 extern std::unique_ptr<OsirisProxy> gOsirisProxy;
 
+class StoryCallScope
+{
+public:
+	inline StoryCallScope()
+	{
+		gOsirisProxy->EnterStoryCall();
+	}
+
+	inline ~StoryCallScope()
+	{
+		gOsirisProxy->ExitStoryCall();
+	}
+};
+
 }
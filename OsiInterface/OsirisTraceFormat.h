@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk format of the binary Osiris trace log.
+// This header is shared between the extender and the offline trace decoder,
+// so it must not depend on any other extender header.
+namespace dse
+{
+	static constexpr uint32_t TraceFileMagic = 0x5254534F; // "OSTR"
+	static constexpr uint32_t TraceFileVersion = 2;
+
+	// Maximum number of characters stored for a string/node name definition
+	static constexpr uint32_t TraceMaxStringLength = 0x1000;
+
+	enum class TraceRecordType : uint8_t
+	{
+		// Assigns an ID to a string value; string columns in later events refer to this ID
+		StringDef = 1,
+		// Describes a story node (type and function name) the first time it is traced
+		NodeDef = 2,
+		// Node hook invocation with its tuple
+		Event = 3,
+		// Number of records that were discarded because the ring buffer was full
+		Dropped = 4,
+		// Story input (event or database insert) received while no story code was running
+		Input = 5
+	};
+
+	enum class TraceEventType : uint8_t
+	{
+		IsValid = 0,
+		PushDown = 1,
+		PushDownDelete = 2,
+		Insert = 3,
+		Delete = 4,
+		CallQuery = 5
+	};
+
+	enum class TraceInputType : uint8_t
+	{
+		// Osiris event thrown by the engine or by the extender
+		Event = 0,
+		// Tuple inserted into a database/proc/event node from Lua
+		Insert = 1,
+		// Tuple deleted from a database node from Lua
+		Delete = 2
+	};
+
+#pragma pack(push, 1)
+	struct TraceFileHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		// Identifies the story the trace was recorded from (see ComputeTraceStoryId());
+		// node IDs and function handles in the trace are only valid for this story
+		uint64_t StoryId;
+	};
+
+	// Every record starts with this header; Size is the size of the payload following the header.
+	//
+	// Record payloads:
+	//  StringDef: uint32 StringId, char[Size - 4] Value
+	//  NodeDef:   uint32 NodeId, uint8 NodeType, uint8 Arity, char[Size - 6] Name
+	//  Event:     uint32 NodeId, uint8 TraceEventType, uint8 NumColumns, TraceColumn[NumColumns]
+	//  Dropped:   uint32 NumDroppedRecords
+	//  Input:     uint8 TraceInputType, uint32 TargetId, uint8 NumColumns, TraceColumn[NumColumns]
+	//             (TargetId is the Osiris function handle for events and the node ID for inserts/deletes)
+	//
+	// Each event column is a uint8 value type (Osiris ValueType) followed by:
+	//  Integer: int32; Integer64: int64; Real: float;
+	//  String/GUID types: uint32 StringId; None/Undefined: no value
+	struct TraceRecordHeader
+	{
+		TraceRecordType Type;
+		uint32_t Size;
+	};
+#pragma pack(pop)
+}
@@ -0,0 +1,313 @@
+#include "stdafx.h"
+#include "OsirisTraceReplay.h"
+#include "OsirisProxy.h"
+#include "OsirisTracer.h"
+#include <chrono>
+#include <fstream>
+
+namespace dse
+{
+	template <class T>
+	static bool ReadValue(std::vector<uint8_t> const & buf, std::size_t & pos, T & value)
+	{
+		if (pos + sizeof(T) > buf.size()) return false;
+		memcpy(&value, buf.data() + pos, sizeof(T));
+		pos += sizeof(T);
+		return true;
+	}
+
+	bool OsirisTraceReplay::Load(std::string const & path)
+	{
+		strings_.clear();
+		inputs_.clear();
+		columns_.clear();
+		maxColumns_ = 0;
+
+		std::ifstream f(path.c_str(), std::ios::in | std::ios::binary);
+		if (!f.good()) {
+			OsiError("Could not open trace file: " << path);
+			return false;
+		}
+
+		TraceFileHeader header;
+		if (!f.read(reinterpret_cast<char *>(&header), sizeof(header))
+			|| header.Magic != TraceFileMagic
+			|| header.Version != TraceFileVersion) {
+			OsiError("Not a supported Osiris trace file: " << path);
+			return false;
+		}
+
+		storyId_ = header.StoryId;
+
+		std::vector<uint8_t> payload;
+		TraceRecordHeader record;
+		while (f.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+			payload.resize(record.Size);
+			if (record.Size > 0 && !f.read(reinterpret_cast<char *>(payload.data()), record.Size)) {
+				OsiError("Trace file is truncated; last record is incomplete");
+				return false;
+			}
+
+			switch (record.Type) {
+			case TraceRecordType::StringDef:
+			{
+				std::size_t pos = 0;
+				uint32_t id;
+				if (!ReadValue(payload, pos, id)) {
+					OsiErrorS("Malformed StringDef record in trace file");
+					return false;
+				}
+
+				strings_[id] = std::string(payload.begin() + pos, payload.end());
+				break;
+			}
+
+			case TraceRecordType::Input:
+				if (!ParseInput(payload)) {
+					OsiErrorS("Malformed Input record in trace file");
+					return false;
+				}
+				break;
+
+			case TraceRecordType::Dropped:
+				OsiWarnS("Trace file has dropped records; replay will be incomplete");
+				break;
+
+			default:
+				// Node events are not needed for replaying
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	bool OsirisTraceReplay::ParseInput(std::vector<uint8_t> const & payload)
+	{
+		std::size_t pos = 0;
+		Input input;
+		if (!ReadValue(payload, pos, input.Type)
+			|| !ReadValue(payload, pos, input.TargetId)
+			|| !ReadValue(payload, pos, input.NumColumns)) {
+			return false;
+		}
+
+		input.FirstColumn = (uint32_t)columns_.size();
+		for (unsigned i = 0; i < input.NumColumns; i++) {
+			Column column{};
+			uint8_t type;
+			if (!ReadValue(payload, pos, type)) return false;
+			column.Type = (ValueType)type;
+
+			bool ok;
+			switch (column.Type) {
+			case ValueType::None:
+			case ValueType::Undefined: ok = true; break;
+			case ValueType::Integer: ok = ReadValue(payload, pos, column.Int32); break;
+			case ValueType::Integer64: ok = ReadValue(payload, pos, column.Int64); break;
+			case ValueType::Real: ok = ReadValue(payload, pos, column.Float); break;
+			default: ok = ReadValue(payload, pos, column.StringId); break;
+			}
+
+			if (!ok) return false;
+			columns_.push_back(column);
+		}
+
+		if (input.NumColumns > maxColumns_) {
+			maxColumns_ = input.NumColumns;
+		}
+
+		inputs_.push_back(input);
+		return true;
+	}
+
+	char const * OsirisTraceReplay::GetString(uint32_t stringId) const
+	{
+		auto it = strings_.find(stringId);
+		return (it != strings_.end()) ? it->second.c_str() : "";
+	}
+
+	bool OsirisTraceReplay::MatchesSignature(Input const & input, Function const * function) const
+	{
+		auto const & params = function->Signature->Params->Params;
+		if (input.NumColumns != params.Size) {
+			return false;
+		}
+
+		// Integer and real values must have the exact type of the parameter;
+		// string values are accepted for any string or GUID parameter
+		auto param = params.Head->Next;
+		for (unsigned i = 0; i < input.NumColumns; i++, param = param->Next) {
+			auto columnType = columns_[input.FirstColumn + i].Type;
+			auto paramType = (ValueType)param->Item.Type;
+			if (columnType == ValueType::None || columnType == ValueType::Undefined) {
+				return false;
+			}
+
+			if (columnType != paramType
+				&& (columnType < ValueType::String || paramType < ValueType::String)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool OsirisTraceReplay::ReplayEvent(Input const & input, std::unordered_map<uint32_t, Function *> const & events,
+		std::vector<OsiArgumentDesc> & args)
+	{
+		auto event = events.find(input.TargetId);
+		if (event == events.end() || !MatchesSignature(input, event->second)) {
+			return false;
+		}
+
+		for (unsigned i = 0; i < input.NumColumns; i++) {
+			auto const & column = columns_[input.FirstColumn + i];
+			auto & arg = args[i].Value;
+			arg.TypeId = column.Type;
+			switch (column.Type) {
+			case ValueType::None:
+			case ValueType::Undefined: break;
+			case ValueType::Integer: arg.Int32 = column.Int32; break;
+			case ValueType::Integer64: arg.Int64 = column.Int64; break;
+			case ValueType::Real: arg.Float = column.Float; break;
+			default: arg.String = GetString(column.StringId); break;
+			}
+
+			args[i].NextParam = (i + 1 < input.NumColumns) ? &args[i + 1] : nullptr;
+		}
+
+		auto osiris = gOsirisProxy->GetDynamicGlobals().OsirisObject;
+		gOsirisProxy->GetWrappers().Event.CallWithHooks(osiris, input.TargetId,
+			input.NumColumns > 0 ? args.data() : nullptr);
+		return true;
+	}
+
+	bool OsirisTraceReplay::ReplayInsert(Input const & input, std::vector<TypedValue> & values,
+		std::vector<ListNode<TypedValue *>> & nodes)
+	{
+		auto const & nodeDb = (*gOsirisProxy->GetGlobals().Nodes)->Db;
+		if (input.TargetId == 0 || input.TargetId > nodeDb.Size) {
+			return false;
+		}
+
+		// Only function nodes that Ext.Osiris accepts inserts/deletes for can be replayed to
+		auto node = nodeDb.Start[input.TargetId - 1];
+		auto function = node->Function;
+		if (function == nullptr || function->Node.Id != input.TargetId) {
+			return false;
+		}
+
+		if (input.Type == TraceInputType::Delete) {
+			if (function->Type != FunctionType::Database) {
+				return false;
+			}
+		} else if (function->Type != FunctionType::Database
+			&& function->Type != FunctionType::Proc
+			&& function->Type != FunctionType::Event) {
+			return false;
+		}
+
+		if (!MatchesSignature(input, function)) {
+			return false;
+		}
+
+		TuplePtrLL tuple;
+		auto & items = tuple.Items;
+		items.Init(&nodes[0]);
+
+		auto prev = items.Head;
+		for (unsigned i = 0; i < input.NumColumns; i++) {
+			auto const & column = columns_[input.FirstColumn + i];
+			auto & tv = values[i];
+			tv.VMT = gOsirisProxy->GetGlobals().TypedValueVMT;
+			tv.TypeId = (uint32_t)column.Type;
+			switch (column.Type) {
+			case ValueType::None:
+			case ValueType::Undefined: break;
+			case ValueType::Integer: tv.Value.Val.Int32 = column.Int32; break;
+			case ValueType::Integer64: tv.Value.Val.Int64 = column.Int64; break;
+			case ValueType::Real: tv.Value.Val.Float = column.Float; break;
+			default: tv.Value.Val.String = const_cast<char *>(GetString(column.StringId)); break;
+			}
+
+			items.Insert(&tv, &nodes[i + 1], prev);
+			prev = &nodes[i + 1];
+		}
+
+		StoryCallScope storyCall;
+		if (input.Type == TraceInputType::Delete) {
+			node->DeleteTuple(&tuple);
+		} else {
+			node->InsertTuple(&tuple);
+		}
+
+		return true;
+	}
+
+	OsirisTraceReplay::Stats OsirisTraceReplay::Run()
+	{
+		Stats stats;
+		if (!gOsirisProxy->IsStoryLoaded()) {
+			OsiErrorS("Cannot replay trace: Story is not loaded");
+			return stats;
+		}
+
+		auto const & globals = gOsirisProxy->GetGlobals();
+		if (ComputeTraceStoryId(globals) != storyId_) {
+			OsiErrorS("Cannot replay trace: It was recorded with a different story");
+			return stats;
+		}
+
+		// Event inputs may only reference event functions of the loaded story
+		std::unordered_map<uint32_t, Function *> events;
+		(*globals.Functions)->Iterate([&events](STDString const &, Function * function) {
+			if (function->Type == FunctionType::Event) {
+				events.insert(std::make_pair(function->GetHandle(), function));
+			}
+		});
+
+		// Argument buffers are reused for all inputs
+		std::vector<OsiArgumentDesc> args(maxColumns_);
+		std::vector<TypedValue> values(maxColumns_);
+		std::vector<ListNode<TypedValue *>> nodes(maxColumns_ + 1);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (auto const & input : inputs_) {
+			switch (input.Type) {
+			case TraceInputType::Event:
+				if (ReplayEvent(input, events, args)) {
+					stats.Events++;
+				} else {
+					stats.Skipped++;
+				}
+				break;
+
+			case TraceInputType::Insert:
+			case TraceInputType::Delete:
+				if (!ReplayInsert(input, values, nodes)) {
+					stats.Skipped++;
+				} else if (input.Type == TraceInputType::Insert) {
+					stats.Inserts++;
+				} else {
+					stats.Deletes++;
+				}
+				break;
+
+			default:
+				stats.Skipped++;
+				break;
+			}
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+		stats.Seconds = std::chrono::duration<double>(end - start).count();
+
+		// Argument descriptors are linked into the vector; don't let ~OsiArgumentDesc() free them
+		for (auto & arg : args) {
+			arg.NextParam = nullptr;
+		}
+
+		return stats;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <GameDefinitions/Osiris.h>
+#include "OsirisTraceFormat.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dse
+{
+	// Replays the story inputs (Input records) of a binary Osiris trace against the loaded story.
+	// Events are thrown through the regular event hooks and inserts go directly to the story nodes,
+	// so the custom function and Lua layers execute the same way as when the trace was recorded.
+	// The trace must have been recorded with the same story, as function handles and node IDs are
+	// only valid within the story they were recorded from. Traces of other stories are rejected, and
+	// each input is checked against the signature of its target before it is passed to Osiris.
+	// Replaying requires the game's Osiris runtime; there is no offline (stub Osiris) replay driver.
+	class OsirisTraceReplay
+	{
+	public:
+		struct Stats
+		{
+			uint32_t Events{ 0 };
+			uint32_t Inserts{ 0 };
+			uint32_t Deletes{ 0 };
+			// Inputs that referenced a nonexistent node/function or didn't match its signature
+			uint32_t Skipped{ 0 };
+			double Seconds{ 0.0 };
+		};
+
+		bool Load(std::string const & path);
+		Stats Run();
+
+		inline std::size_t NumInputs() const
+		{
+			return inputs_.size();
+		}
+
+	private:
+		struct Column
+		{
+			ValueType Type;
+			int32_t Int32;
+			int64_t Int64;
+			float Float;
+			uint32_t StringId;
+		};
+
+		struct Input
+		{
+			TraceInputType Type;
+			uint32_t TargetId;
+			uint32_t FirstColumn;
+			uint8_t NumColumns;
+		};
+
+		uint64_t storyId_{ 0 };
+		std::unordered_map<uint32_t, std::string> strings_;
+		std::vector<Input> inputs_;
+		std::vector<Column> columns_;
+		uint8_t maxColumns_{ 0 };
+
+		bool ParseInput(std::vector<uint8_t> const & payload);
+		char const * GetString(uint32_t stringId) const;
+		bool MatchesSignature(Input const & input, Function const * function) const;
+		bool ReplayEvent(Input const & input, std::unordered_map<uint32_t, Function *> const & events,
+			std::vector<OsiArgumentDesc> & args);
+		bool ReplayInsert(Input const & input, std::vector<TypedValue> & values,
+			std::vector<ListNode<TypedValue *>> & nodes);
+	};
+}
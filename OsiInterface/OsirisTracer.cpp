@@ -0,0 +1,464 @@
+#include "stdafx.h"
+#include "OsirisTracer.h"
+#include "NodeHooks.h"
+#include <chrono>
+
+namespace dse
+{
+	static void HashBytes(uint64_t & hash, void const * data, std::size_t size)
+	{
+		// FNV-1a
+		auto bytes = reinterpret_cast<uint8_t const *>(data);
+		for (std::size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+		}
+	}
+
+	static void HashFunction(uint64_t & hash, Function const * function)
+	{
+		auto type = (uint32_t)function->Type;
+		auto name = function->Signature->Name;
+		auto numParams = (uint32_t)function->Signature->Params->Params.Size;
+		HashBytes(hash, &type, sizeof(type));
+		HashBytes(hash, &numParams, sizeof(numParams));
+		HashBytes(hash, name, strlen(name));
+	}
+
+	uint64_t ComputeTraceStoryId(OsirisStaticGlobals const & globals)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		// Node IDs are referenced by insert/delete inputs
+		auto const & nodeDb = (*globals.Nodes)->Db;
+		HashBytes(hash, &nodeDb.Size, sizeof(nodeDb.Size));
+		for (uint32_t i = 0; i < nodeDb.Size; i++) {
+			auto function = nodeDb.Start[i]->Function;
+			if (function != nullptr) {
+				HashFunction(hash, function);
+			} else {
+				HashBytes(hash, &i, sizeof(i));
+			}
+		}
+
+		// Function handles are referenced by event inputs.
+		// The function table is a hash map, so entries are combined independently of their order.
+		uint64_t functionsHash = 0;
+		(*globals.Functions)->Iterate([&functionsHash](STDString const &, Function * function) {
+			uint64_t entryHash = 0xcbf29ce484222325ull;
+			auto handle = function->GetHandle();
+			HashBytes(entryHash, &handle, sizeof(handle));
+			HashFunction(entryHash, function);
+			functionsHash += entryHash;
+		});
+
+		HashBytes(hash, &functionsHash, sizeof(functionsHash));
+		return hash;
+	}
+
+	TraceRingBuffer::TraceRingBuffer(std::size_t capacity)
+	{
+		// Round up to the next power of two, so offsets can be masked instead of divided
+		capacity_ = 1;
+		while (capacity_ < capacity) {
+			capacity_ <<= 1;
+		}
+
+		mask_ = capacity_ - 1;
+		buffer_ = std::make_unique<uint8_t[]>(capacity_);
+	}
+
+	bool TraceRingBuffer::Write(void const * data, std::size_t size)
+	{
+		auto head = head_.load(std::memory_order_relaxed);
+		auto tail = tail_.load(std::memory_order_acquire);
+		if (capacity_ - (head - tail) < size) {
+			return false;
+		}
+
+		auto offset = head & mask_;
+		auto firstPart = std::min(size, capacity_ - offset);
+		memcpy(buffer_.get() + offset, data, firstPart);
+		if (firstPart < size) {
+			memcpy(buffer_.get(), reinterpret_cast<uint8_t const *>(data) + firstPart, size - firstPart);
+		}
+
+		head_.store(head + size, std::memory_order_release);
+		return true;
+	}
+
+	std::size_t TraceRingBuffer::Peek(uint8_t const *& data) const
+	{
+		auto head = head_.load(std::memory_order_acquire);
+		auto tail = tail_.load(std::memory_order_relaxed);
+		auto offset = tail & mask_;
+		data = buffer_.get() + offset;
+		return std::min(head - tail, capacity_ - offset);
+	}
+
+	void TraceRingBuffer::Consume(std::size_t size)
+	{
+		tail_.store(tail_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+	}
+
+
+	class OsirisTracer::RecordBuilder
+	{
+	public:
+		inline RecordBuilder(TraceRecordType type)
+		{
+			auto header = reinterpret_cast<TraceRecordHeader *>(buf_);
+			header->Type = type;
+			header->Size = 0;
+		}
+
+		template <class T>
+		inline void Append(T const & value)
+		{
+			memcpy(buf_ + size_, &value, sizeof(T));
+			size_ += sizeof(T);
+		}
+
+		inline void AppendString(char const * str)
+		{
+			auto length = strnlen(str, TraceMaxStringLength);
+			memcpy(buf_ + size_, str, length);
+			size_ += length;
+		}
+
+		inline std::size_t Offset() const
+		{
+			return size_;
+		}
+
+		inline void Patch(std::size_t offset, uint8_t value)
+		{
+			buf_[offset] = value;
+		}
+
+		inline uint8_t const * Finish()
+		{
+			auto header = reinterpret_cast<TraceRecordHeader *>(buf_);
+			header->Size = (uint32_t)(size_ - sizeof(TraceRecordHeader));
+			return buf_;
+		}
+
+		inline std::size_t Size() const
+		{
+			return size_;
+		}
+
+		uint8_t NumColumns{ 0 };
+
+	private:
+		uint8_t buf_[MaxRecordSize];
+		std::size_t size_{ sizeof(TraceRecordHeader) };
+	};
+
+
+	OsirisTracer::OsirisTracer(std::wstring const & path, std::size_t bufferSize)
+		: path_(path), ring_(bufferSize)
+	{}
+
+	OsirisTracer::~OsirisTracer()
+	{
+		Stop();
+	}
+
+	bool OsirisTracer::Start(uint64_t storyId)
+	{
+		if (running_) return true;
+
+		file_ = CreateFileW(path_.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file_ == INVALID_HANDLE_VALUE) {
+			ERR(L"OsirisTracer::Start(): Could not open trace file '%s': error %d", path_.c_str(), GetLastError());
+			return false;
+		}
+
+		TraceFileHeader header{ TraceFileMagic, TraceFileVersion, storyId };
+		DWORD written;
+		WriteFile(file_, &header, sizeof(header), &written, NULL);
+
+		running_ = true;
+		writerThread_ = std::make_unique<std::thread>(std::bind(&OsirisTracer::WriterThread, this));
+		DEBUG(L"OsirisTracer::Start(): Writing binary trace to %s", path_.c_str());
+		return true;
+	}
+
+	void OsirisTracer::Stop()
+	{
+		if (!running_) return;
+
+		running_ = false;
+		writerThread_->join();
+		writerThread_.reset();
+
+		CloseHandle(file_);
+		file_ = INVALID_HANDLE_VALUE;
+
+		if (totalDropped_ > 0) {
+			WARN("OsirisTracer::Stop(): %lld trace records were dropped due to a full trace buffer", totalDropped_);
+		}
+	}
+
+	void OsirisTracer::WriterThread()
+	{
+		while (running_) {
+			FlushToDisk();
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		// Drain records that were written after the last flush
+		FlushToDisk();
+	}
+
+	void OsirisTracer::FlushToDisk()
+	{
+		uint8_t const * data;
+		std::size_t size;
+		while ((size = ring_.Peek(data)) > 0) {
+			DWORD written;
+			if (!WriteFile(file_, data, (DWORD)size, &written, NULL)) {
+				ERR("OsirisTracer::FlushToDisk(): Write failed: error %d", GetLastError());
+			}
+
+			ring_.Consume(size);
+		}
+	}
+
+	void OsirisTracer::DropRecord()
+	{
+		droppedSinceLastWrite_++;
+		totalDropped_++;
+	}
+
+	bool OsirisTracer::CommitRecord(RecordBuilder & record)
+	{
+		auto buf = record.Finish();
+		return ring_.Write(buf, record.Size());
+	}
+
+	bool OsirisTracer::BeginRecord()
+	{
+		if (!running_) return false;
+
+		// Let the decoder know that there is a gap in the trace
+		if (droppedSinceLastWrite_ > 0) {
+			RecordBuilder record(TraceRecordType::Dropped);
+			record.Append(droppedSinceLastWrite_);
+			if (!CommitRecord(record)) {
+				return false;
+			}
+
+			droppedSinceLastWrite_ = 0;
+		}
+
+		return true;
+	}
+
+	bool OsirisTracer::DefineNode(Node * node)
+	{
+		if (node->Id < definedNodes_.size() && definedNodes_[node->Id]) {
+			return true;
+		}
+
+		RecordBuilder record(TraceRecordType::NodeDef);
+		record.Append(node->Id);
+		record.Append((uint8_t)gNodeVMTWrappers->GetType(node));
+		if (node->Function != nullptr) {
+			auto signature = node->Function->Signature;
+			record.Append((uint8_t)signature->Params->Params.Size);
+			record.AppendString(signature->Name);
+		} else {
+			record.Append((uint8_t)0);
+		}
+
+		if (!CommitRecord(record)) {
+			return false;
+		}
+
+		if (node->Id >= definedNodes_.size()) {
+			definedNodes_.resize(node->Id + 1);
+		}
+
+		definedNodes_[node->Id] = true;
+		return true;
+	}
+
+	bool OsirisTracer::InternString(char const * str, uint32_t & id)
+	{
+		std::string_view key(str);
+		auto it = stringIds_.find(key);
+		if (it != stringIds_.end()) {
+			id = it->second;
+			return true;
+		}
+
+		id = (uint32_t)strings_.size();
+		RecordBuilder record(TraceRecordType::StringDef);
+		record.Append(id);
+		record.AppendString(str);
+		if (!CommitRecord(record)) {
+			return false;
+		}
+
+		// Only assign the ID after the definition made it to the ring,
+		// otherwise the decoder would see references to an undefined string
+		auto const & stored = strings_.emplace_back(key);
+		stringIds_.insert(std::make_pair(std::string_view(stored), id));
+		return true;
+	}
+
+	bool OsirisTracer::AddColumn(RecordBuilder & record, ValueType type, int32_t int32Val, int64_t int64Val, float floatVal, char const * strVal)
+	{
+		if (record.NumColumns == 0xff) {
+			return true;
+		}
+
+		record.Append((uint8_t)type);
+		switch (type) {
+		case ValueType::None:
+		case ValueType::Undefined:
+			break;
+
+		case ValueType::Integer:
+			record.Append(int32Val);
+			break;
+
+		case ValueType::Integer64:
+			record.Append(int64Val);
+			break;
+
+		case ValueType::Real:
+			record.Append(floatVal);
+			break;
+
+		default:
+		{
+			uint32_t stringId;
+			if (!InternString(strVal != nullptr ? strVal : "", stringId)) {
+				return false;
+			}
+
+			record.Append(stringId);
+			break;
+		}
+		}
+
+		record.NumColumns++;
+		return true;
+	}
+
+	bool OsirisTracer::AddColumn(RecordBuilder & record, TypedValue const & value)
+	{
+		auto const & val = value.Value.Val;
+		return AddColumn(record, (ValueType)value.TypeId, val.Int32, val.Int64, val.Float, val.String);
+	}
+
+	bool OsirisTracer::AddColumn(RecordBuilder & record, OsiArgumentValue const & value)
+	{
+		return AddColumn(record, value.TypeId, value.Int32, value.Int64, value.Float, value.String);
+	}
+
+	template <class Visitor>
+	void OsirisTracer::TraceEvent(TraceEventType type, Node * node, Visitor visitColumns)
+	{
+		if (!BeginRecord() || !DefineNode(node)) {
+			DropRecord();
+			return;
+		}
+
+		RecordBuilder record(TraceRecordType::Event);
+		record.Append(node->Id);
+		record.Append((uint8_t)type);
+		auto numColumnsOffset = record.Offset();
+		record.Append((uint8_t)0);
+
+		if (!visitColumns(record)) {
+			DropRecord();
+			return;
+		}
+
+		record.Patch(numColumnsOffset, record.NumColumns);
+		if (!CommitRecord(record)) {
+			DropRecord();
+		}
+	}
+
+	void OsirisTracer::Trace(TraceEventType type, Node * node, TupleLL const & tuple)
+	{
+		TraceEvent(type, node, [this, &tuple](RecordBuilder & record) {
+			auto head = tuple.Items.Head;
+			for (auto col = head->Next; col != head; col = col->Next) {
+				if (!AddColumn(record, col->Item.Value)) return false;
+			}
+			return true;
+		});
+	}
+
+	void OsirisTracer::Trace(TraceEventType type, Node * node, TuplePtrLL const & tuple)
+	{
+		TraceEvent(type, node, [this, &tuple](RecordBuilder & record) {
+			auto head = tuple.Items.Head;
+			for (auto col = head->Next; col != head; col = col->Next) {
+				if (!AddColumn(record, *col->Item)) return false;
+			}
+			return true;
+		});
+	}
+
+	void OsirisTracer::Trace(TraceEventType type, Node * node, OsiArgumentDesc const * args)
+	{
+		TraceEvent(type, node, [this, args](RecordBuilder & record) {
+			for (auto arg = args; arg != nullptr; arg = arg->NextParam) {
+				if (!AddColumn(record, arg->Value)) return false;
+			}
+			return true;
+		});
+	}
+
+	template <class Visitor>
+	void OsirisTracer::TraceInputRecord(TraceInputType type, uint32_t targetId, Visitor visitColumns)
+	{
+		if (!BeginRecord()) {
+			DropRecord();
+			return;
+		}
+
+		RecordBuilder record(TraceRecordType::Input);
+		record.Append((uint8_t)type);
+		record.Append(targetId);
+		auto numColumnsOffset = record.Offset();
+		record.Append((uint8_t)0);
+
+		if (!visitColumns(record)) {
+			DropRecord();
+			return;
+		}
+
+		record.Patch(numColumnsOffset, record.NumColumns);
+		if (!CommitRecord(record)) {
+			DropRecord();
+		}
+	}
+
+	void OsirisTracer::TraceInput(uint32_t functionHandle, OsiArgumentDesc const * args)
+	{
+		TraceInputRecord(TraceInputType::Event, functionHandle, [this, args](RecordBuilder & record) {
+			for (auto arg = args; arg != nullptr; arg = arg->NextParam) {
+				if (!AddColumn(record, arg->Value)) return false;
+			}
+			return true;
+		});
+	}
+
+	void OsirisTracer::TraceInput(TraceInputType type, Node * node, TuplePtrLL const & tuple)
+	{
+		TraceInputRecord(type, node->Id, [this, &tuple](RecordBuilder & record) {
+			auto head = tuple.Items.Head;
+			for (auto col = head->Next; col != head; col = col->Next) {
+				if (!AddColumn(record, *col->Item)) return false;
+			}
+			return true;
+		});
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <GameDefinitions/Osiris.h>
+#include "OsirisTraceFormat.h"
+#include <atomic>
+#include <deque>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace dse
+{
+	// Hashes the node table and function signatures of the loaded story.
+	// Traces record this value, so a trace is only replayed against the story it was recorded from.
+	uint64_t ComputeTraceStoryId(OsirisStaticGlobals const & globals);
+
+	// Lock-free single producer/single consumer byte ring.
+	// The producer (Osiris server thread) never blocks; if there is not enough space
+	// for a record, the record is discarded and the caller is notified.
+	class TraceRingBuffer
+	{
+	public:
+		TraceRingBuffer(std::size_t capacity);
+
+		bool Write(void const * data, std::size_t size);
+		// Returns the contiguous readable region; call Consume() after the data was processed
+		std::size_t Peek(uint8_t const *& data) const;
+		void Consume(std::size_t size);
+
+	private:
+		std::unique_ptr<uint8_t[]> buffer_;
+		std::size_t capacity_;
+		std::size_t mask_;
+		alignas(64) std::atomic<std::size_t> head_{ 0 };
+		alignas(64) std::atomic<std::size_t> tail_{ 0 };
+	};
+
+	// Writes a compact binary trace of story node calls.
+	// Records are built on the server thread and drained to disk by a background writer thread.
+	class OsirisTracer
+	{
+	public:
+		static constexpr std::size_t DefaultBufferSize = 0x1000000; // 16 MB
+
+		OsirisTracer(std::wstring const & path, std::size_t bufferSize = DefaultBufferSize);
+		~OsirisTracer();
+
+		bool Start(uint64_t storyId);
+		void Stop();
+
+		void Trace(TraceEventType type, Node * node, TupleLL const & tuple);
+		void Trace(TraceEventType type, Node * node, TuplePtrLL const & tuple);
+		void Trace(TraceEventType type, Node * node, OsiArgumentDesc const * args);
+		// Records story inputs for replaying them later (see OsirisTraceReplay)
+		void TraceInput(uint32_t functionHandle, OsiArgumentDesc const * args);
+		void TraceInput(TraceInputType type, Node * node, TuplePtrLL const & tuple);
+
+		inline uint64_t NumDroppedRecords() const
+		{
+			return totalDropped_;
+		}
+
+	private:
+		// Large enough for an event record with 255 columns (type + 8 byte value each)
+		// and for a node/string definition of TraceMaxStringLength characters
+		static constexpr std::size_t MaxRecordSize = sizeof(TraceRecordHeader) + 6 + TraceMaxStringLength;
+		static_assert(MaxRecordSize >= sizeof(TraceRecordHeader) + 6 + 255 * 9, "Trace record buffer too small");
+
+		class RecordBuilder;
+
+		std::wstring path_;
+		HANDLE file_{ INVALID_HANDLE_VALUE };
+		TraceRingBuffer ring_;
+		std::unique_ptr<std::thread> writerThread_;
+		std::atomic<bool> running_{ false };
+
+		// String interning state; only accessed from the producer thread
+		std::unordered_map<std::string_view, uint32_t> stringIds_;
+		std::deque<std::string> strings_;
+		std::vector<bool> definedNodes_;
+		uint32_t droppedSinceLastWrite_{ 0 };
+		uint64_t totalDropped_{ 0 };
+
+		bool BeginRecord();
+		bool CommitRecord(RecordBuilder & record);
+		void DropRecord();
+		bool DefineNode(Node * node);
+		bool InternString(char const * str, uint32_t & id);
+		bool AddColumn(RecordBuilder & record, TypedValue const & value);
+		bool AddColumn(RecordBuilder & record, OsiArgumentValue const & value);
+		bool AddColumn(RecordBuilder & record, ValueType type, int32_t int32Val, int64_t int64Val, float floatVal, char const * strVal);
+
+		template <class Visitor>
+		void TraceEvent(TraceEventType type, Node * node, Visitor visitColumns);
+		template <class Visitor>
+		void TraceInputRecord(TraceInputType type, uint32_t targetId, Visitor visitColumns);
+
+		void WriterThread();
+		void FlushToDisk();
+	};
+}
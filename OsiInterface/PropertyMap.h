@@ -143,6 +143,20 @@ namespace dse
 			return nullptr;
 		}
 
+		// Merges the properties and flags of parent maps into this map, so lookups don't
+		// have to walk the parent chain. Parent offsets can be used directly on the child object,
+		// as toParent() doesn't adjust the object pointer.
+		void flatten()
+		{
+			for (auto parent = Parent; parent != nullptr; parent = parent->Parent) {
+				// Properties of the child map take precedence over the ones in its parents
+				Properties.insert(parent->Properties.begin(), parent->Properties.end());
+				Flags.insert(parent->Flags.begin(), parent->Flags.end());
+			}
+
+			Parent = nullptr;
+		}
+
 		std::optional<int64_t> getInt(void * obj, FixedString const& name, bool raw, bool throwError) const
 		{
 			auto prop = Properties.find(name);
@@ -157,17 +171,22 @@ namespace dse
 				}
 			}
 
-			if (!raw && prop->second.GetInt) {
-				return prop->second.GetInt(obj);
+			return getInt(obj, prop->second, name, raw, throwError);
+		}
+
+		std::optional<int64_t> getInt(void * obj, PropertyInfo const & prop, FixedString const & name, bool raw, bool throwError) const
+		{
+			if (!raw && prop.GetInt) {
+				return prop.GetInt(obj);
 			}
 
-			if (!raw && !(prop->second.Flags & kPropRead)) {
+			if (!raw && !(prop.Flags & kPropRead)) {
 				OsiError("Failed to get int property '" << name << "' of [" << Name << "]: Property not readable");
 				return {};
 			}
 
-			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop->second.Offset;
-			switch (prop->second.Type) {
+			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop.Offset;
+			switch (prop.Type) {
 			case PropertyType::kBool: return (int64_t)*reinterpret_cast<bool *>(ptr);
 			case PropertyType::kUInt8: return (int64_t)*reinterpret_cast<uint8_t *>(ptr);
 			case PropertyType::kInt16: return (int64_t)*reinterpret_cast<int16_t *>(ptr);
@@ -197,17 +216,22 @@ namespace dse
 				}
 			}
 
-			if (!raw && prop->second.GetFloat) {
-				return prop->second.GetFloat(obj);
+			return getFloat(obj, prop->second, name, raw, throwError);
+		}
+
+		std::optional<float> getFloat(void * obj, PropertyInfo const & prop, FixedString const & name, bool raw, bool throwError) const
+		{
+			if (!raw && prop.GetFloat) {
+				return prop.GetFloat(obj);
 			}
 
-			if (!raw && !(prop->second.Flags & kPropRead)) {
+			if (!raw && !(prop.Flags & kPropRead)) {
 				OsiError("Failed to get float property '" << name << "' of [" << Name << "]: Property not readable");
 				return {};
 			}
 
-			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop->second.Offset;
-			switch (prop->second.Type) {
+			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop.Offset;
+			switch (prop.Type) {
 			case PropertyType::kFloat: return *reinterpret_cast<float *>(ptr);
 			default:
 				OsiError("Failed to get property '" << name << "' of [" << Name << "]: Property is not a float");
@@ -305,17 +329,22 @@ namespace dse
 				}
 			}
 
-			if (!raw && prop->second.GetString) {
-				return prop->second.GetString(obj);
+			return getString(obj, prop->second, name, raw, throwError);
+		}
+
+		std::optional<char const *> getString(void * obj, PropertyInfo const & prop, FixedString const & name, bool raw, bool throwError) const
+		{
+			if (!raw && prop.GetString) {
+				return prop.GetString(obj);
 			}
 
-			if (!raw && !(prop->second.Flags & kPropRead)) {
+			if (!raw && !(prop.Flags & kPropRead)) {
 				OsiError("Failed to get string property '" << name << "' of [" << Name << "]: Property not readable");
 				return {};
 			}
 
-			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop->second.Offset;
-			switch (prop->second.Type) {
+			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop.Offset;
+			switch (prop.Type) {
 			case PropertyType::kFixedString:
 			case PropertyType::kFixedStringGuid:
 			{
@@ -451,17 +480,22 @@ namespace dse
 				}
 			}
 
-			if (!raw && prop->second.GetHandle) {
-				return prop->second.GetHandle(obj);
+			return getHandle(obj, prop->second, name, raw, throwError);
+		}
+
+		std::optional<ObjectHandle> getHandle(void * obj, PropertyInfo const & prop, FixedString const & name, bool raw, bool throwError) const
+		{
+			if (!raw && prop.GetHandle) {
+				return prop.GetHandle(obj);
 			}
 
-			if (!raw && !(prop->second.Flags & kPropRead)) {
+			if (!raw && !(prop.Flags & kPropRead)) {
 				OsiError("Failed to get handle property '" << name << "' of [" << Name << "]: Property not readable");
 				return {};
 			}
 
-			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop->second.Offset;
-			if (prop->second.Type == PropertyType::kObjectHandle) {
+			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop.Offset;
+			if (prop.Type == PropertyType::kObjectHandle) {
 				return *reinterpret_cast<ObjectHandle *>(ptr);
 			} else {
 				OsiError("Failed to get property '" << name << "' of [" << Name << "]: Property is not a handle");
@@ -516,17 +550,22 @@ namespace dse
 				}
 			}
 
-			if (!raw && prop->second.GetVector3) {
-				return prop->second.GetVector3(obj);
+			return getVector3(obj, prop->second, name, raw, throwError);
+		}
+
+		std::optional<Vector3> getVector3(void * obj, PropertyInfo const & prop, FixedString const & name, bool raw, bool throwError) const
+		{
+			if (!raw && prop.GetVector3) {
+				return prop.GetVector3(obj);
 			}
 
-			if (!raw && !(prop->second.Flags & kPropRead)) {
+			if (!raw && !(prop.Flags & kPropRead)) {
 				OsiError("Failed to get vector property '" << name << "' of [" << Name << "]: Property not readable");
 				return {};
 			}
 
-			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop->second.Offset;
-			if (prop->second.Type == PropertyType::kVector3) {
+			auto ptr = reinterpret_cast<std::uintptr_t>(obj) + prop.Offset;
+			if (prop.Type == PropertyType::kVector3) {
 				return *reinterpret_cast<Vector3 *>(ptr);
 			} else {
 				OsiError("Failed to get property '" << name << "' of [" << Name << "]: Property is not a vector");
@@ -3,6 +3,7 @@
 #include <GameDefinitions/Projectile.h>
 #include <GameDefinitions/Surface.h>
 #include "PropertyMaps.h"
+#include <atomic>
 
 namespace dse
 {
@@ -659,6 +660,15 @@ namespace dse
 			PROP_RO(BaseWeightOverwrite);
 			PROP_RO(ItemColorOverride);
 		}
+
+		// Must be done after all parent maps were fully initialized
+		gStatusHitPropertyMap.flatten();
+		gStatusConsumePropertyMap.flatten();
+		gStatusHealingPropertyMap.flatten();
+		gStatusHealPropertyMap.flatten();
+		gEquipmentAttributesWeaponPropertyMap.flatten();
+		gEquipmentAttributesArmorPropertyMap.flatten();
+		gEquipmentAttributesShieldPropertyMap.flatten();
 	}
 
 
@@ -853,16 +863,170 @@ namespace dse
 	}
 
 
+	// Direct-mapped caches of Lua string -> FixedString and Lua string -> property conversions.
+	// Lua strings are keyed by address, which is only unique while the string is alive. Cached strings
+	// are therefore anchored in the registry of the Lua state that added them until their cache slot
+	// is reused, so a hit only needs an address compare. When a Lua state is closed, its anchors are
+	// released and all caches are invalidated (see InvalidateLuaPropertyNameCache()).
+	// Lookups happen on the thread that is running the Lua state, so a thread local cache needs no locking.
+	struct LuaPropertyNameCache
+	{
+		static constexpr std::size_t Size = 512;
+
+		struct NameEntry
+		{
+			char const * Key{ nullptr };
+			FixedString Name;
+		};
+
+		struct PropertyEntry
+		{
+			char const * Key{ nullptr };
+			PropertyMapBase const * Map{ nullptr };
+			FixedString Name;
+			PropertyMapBase::PropertyInfo const * Property{ nullptr };
+		};
+
+		uint32_t Generation{ 0 };
+		NameEntry Names[Size];
+		PropertyEntry Properties[Size];
+	};
+
+	std::atomic<uint32_t> gLuaPropertyNameCacheGeneration{ 1 };
+
+	// Intentionally never freed; releasing the cached names during thread/process shutdown
+	// could touch the global string table after the game has already destroyed it
+	thread_local LuaPropertyNameCache * gLuaPropertyNameCache{ nullptr };
+
+	void InvalidateLuaPropertyNameCache()
+	{
+		gLuaPropertyNameCacheGeneration++;
+	}
+
+	static LuaPropertyNameCache & GetLuaPropertyNameCache()
+	{
+		if (gLuaPropertyNameCache == nullptr) {
+			gLuaPropertyNameCache = new LuaPropertyNameCache();
+		}
+
+		auto generation = gLuaPropertyNameCacheGeneration.load();
+		if (gLuaPropertyNameCache->Generation != generation) {
+			for (auto & entry : gLuaPropertyNameCache->Names) {
+				entry = LuaPropertyNameCache::NameEntry();
+			}
+
+			for (auto & entry : gLuaPropertyNameCache->Properties) {
+				entry = LuaPropertyNameCache::PropertyEntry();
+			}
+
+			gLuaPropertyNameCache->Generation = generation;
+		}
+
+		return *gLuaPropertyNameCache;
+	}
+
+	static std::size_t GetLuaPropertyNameSlot(void const * key)
+	{
+		auto addr = reinterpret_cast<std::uintptr_t>(key);
+		return ((addr >> 4) ^ (addr >> 13)) & (LuaPropertyNameCache::Size - 1);
+	}
+
+	// Keeps the string at the specified (absolute) index alive while it is in the cache slot.
+	// Name and property slots are anchored separately.
+	static void AnchorLuaPropertyName(lua_State * L, int index, int anchorSlot)
+	{
+		lua_getfield(L, LUA_REGISTRYINDEX, "PropertyNameAnchors");
+		if (lua_type(L, -1) != LUA_TTABLE) {
+			lua_pop(L, 1);
+			lua_newtable(L);
+			lua_pushvalue(L, -1);
+			lua_setfield(L, LUA_REGISTRYINDEX, "PropertyNameAnchors");
+		}
+
+		lua_pushvalue(L, index);
+		lua_rawseti(L, -2, anchorSlot);
+		lua_pop(L, 1);
+	}
+
+	static int ToAbsoluteIndex(lua_State * L, int index)
+	{
+		return (index < 0 && index > LUA_REGISTRYINDEX) ? lua_gettop(L) + index + 1 : index;
+	}
+
+	FixedString LuaToFixedString(lua_State * L, int index)
+	{
+		auto name = lua_tostring(L, index);
+		if (name == nullptr) {
+			return FixedString{};
+		}
+
+		auto & cache = GetLuaPropertyNameCache();
+		auto slot = GetLuaPropertyNameSlot(name);
+		auto & entry = cache.Names[slot];
+		if (entry.Key == name) {
+			return entry.Name;
+		}
+
+		auto fs = ToFixedString(name);
+		// Names that aren't in the string table yet are not cached, as they may be added later
+		if (fs) {
+			AnchorLuaPropertyName(L, ToAbsoluteIndex(L, index), (int)slot + 1);
+			entry.Key = name;
+			entry.Name = fs;
+		}
+
+		return fs;
+	}
+
+	PropertyMapBase::PropertyInfo const * LuaFindProperty(lua_State * L, int index, PropertyMapBase const & propertyMap,
+		FixedString & propertyName)
+	{
+		auto name = lua_tostring(L, index);
+		if (name == nullptr) {
+			propertyName = FixedString{};
+			return nullptr;
+		}
+
+		auto & cache = GetLuaPropertyNameCache();
+		auto slot = GetLuaPropertyNameSlot(name) ^ GetLuaPropertyNameSlot(&propertyMap);
+		auto & entry = cache.Properties[slot];
+		if (entry.Key == name && entry.Map == &propertyMap) {
+			propertyName = entry.Name;
+			return entry.Property;
+		}
+
+		propertyName = LuaToFixedString(L, index);
+		if (!propertyName) {
+			return nullptr;
+		}
+
+		auto prop = propertyMap.findProperty(propertyName);
+		AnchorLuaPropertyName(L, ToAbsoluteIndex(L, index), (int)(LuaPropertyNameCache::Size + slot) + 1);
+		entry.Key = name;
+		entry.Map = &propertyMap;
+		entry.Name = propertyName;
+		entry.Property = prop;
+		return prop;
+	}
+
 	bool LuaPropertyMapGet(lua_State* L, PropertyMapBase const& propertyMap, void* obj,
-		char const* propertyName, bool throwError)
+		int nameIndex, bool throwError)
 	{
-		auto propertyFS = ToFixedString(propertyName);
+		if (obj == nullptr) {
+			if (throwError) {
+				OsiError("Attempted to get property '" << lua_tostring(L, nameIndex) << "' of null object!");
+			}
+			return false;
+		}
+
+		FixedString propertyFS;
+		auto prop = LuaFindProperty(L, nameIndex, propertyMap, propertyFS);
 		if (!propertyFS) {
-			OsiError("Failed to get property '" << propertyName << "' of [" << propertyMap.Name << "]: Property does not exist!");
+			OsiError("Failed to get property '" << lua_tostring(L, nameIndex) << "' of [" << propertyMap.Name << "]: Property does not exist!");
 			return false;
 		}
 
-		return LuaPropertyMapGet(L, propertyMap, obj, propertyFS, throwError);
+		return LuaPropertyMapGet(L, propertyMap, obj, propertyFS, prop, throwError);
 	}
 
 	bool LuaPropertyMapGet(lua_State * L, PropertyMapBase const & propertyMap, void * obj,
@@ -875,7 +1039,12 @@ namespace dse
 			return false;
 		}
 
-		auto prop = propertyMap.findProperty(propertyName);
+		return LuaPropertyMapGet(L, propertyMap, obj, propertyName, propertyMap.findProperty(propertyName), throwError);
+	}
+
+	bool LuaPropertyMapGet(lua_State * L, PropertyMapBase const & propertyMap, void * obj,
+		FixedString const& propertyName, PropertyMapBase::PropertyInfo const * prop, bool throwError)
+	{
 		if (prop == nullptr) {
 			auto flag = propertyMap.findFlag(propertyName);
 			if (flag == nullptr) {
@@ -903,7 +1072,7 @@ namespace dse
 		switch (type) {
 		case PropertyType::kBool:
 		{
-			auto val = propertyMap.getInt(obj, propertyName, false, throwError);
+			auto val = propertyMap.getInt(obj, *prop, propertyName, false, throwError);
 			if (val) {
 				lua::push(L, *val != 0);
 				return true;
@@ -920,7 +1089,7 @@ namespace dse
 		case PropertyType::kInt64:
 		case PropertyType::kUInt64:
 		{
-			auto val = propertyMap.getInt(obj, propertyName, false, throwError);
+			auto val = propertyMap.getInt(obj, *prop, propertyName, false, throwError);
 			if (val) {
 				lua::push(L, *val);
 				return true;
@@ -931,7 +1100,7 @@ namespace dse
 
 		case PropertyType::kFloat:
 		{
-			auto val = propertyMap.getFloat(obj, propertyName, false, throwError);
+			auto val = propertyMap.getFloat(obj, *prop, propertyName, false, throwError);
 			if (val) {
 				lua::push(L, *val);
 				return true;
@@ -946,7 +1115,7 @@ namespace dse
 		case PropertyType::kStdString:
 		case PropertyType::kStdWString:
 		{
-			auto val = propertyMap.getString(obj, propertyName, false, throwError);
+			auto val = propertyMap.getString(obj, *prop, propertyName, false, throwError);
 			if (val) {
 				lua::push(L, *val);
 				return true;
@@ -957,7 +1126,7 @@ namespace dse
 
 		case PropertyType::kObjectHandle:
 		{
-			auto val = propertyMap.getHandle(obj, propertyName, false, throwError);
+			auto val = propertyMap.getHandle(obj, *prop, propertyName, false, throwError);
 			if (val) {
 				if (*val) {
 					lua::push(L, val->Handle);
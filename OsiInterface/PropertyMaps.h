@@ -70,10 +70,50 @@ namespace dse
 		return OsirisPropertyMapSetRaw(propertyMap, obj, args, firstArg, type, throwError);
 	}
 
+	// Converts the property name at the specified stack index to a FixedString.
+	// Uses a per-thread cache keyed by the address of the Lua string, so repeated accesses
+	// with the same key skip the global string table lookup.
+	FixedString LuaToFixedString(lua_State * L, int index);
+	// Looks up the property named by the string at the specified stack index.
+	// Cached the same way as LuaToFixedString(), per property map.
+	PropertyMapBase::PropertyInfo const * LuaFindProperty(lua_State * L, int index, PropertyMapBase const & propertyMap,
+		FixedString & propertyName);
+	// Must be called when a Lua state is closed, as the cached names may be reused afterwards
+	void InvalidateLuaPropertyNameCache();
+
 	bool LuaPropertyMapGet(lua_State * L, PropertyMapBase const & propertyMap, void * obj,
-		char const * propertyName, bool throwError);
+		int nameIndex, bool throwError);
 	bool LuaPropertyMapGet(lua_State* L, PropertyMapBase const& propertyMap, void* obj,
 		FixedString const& propertyName, bool throwError);
+	bool LuaPropertyMapGet(lua_State * L, PropertyMapBase const & propertyMap, void * obj,
+		FixedString const& propertyName, PropertyMapBase::PropertyInfo const * prop, bool throwError);
 	bool LuaPropertyMapSet(lua_State * L, int index, PropertyMapBase const & propertyMap,
 		void * obj, char const * propertyName, bool throwError);
+
+	// Fetches the properties listed in the table at namesIndex and returns them in a new table keyed
+	// by property name. fetch(name, nameFS) should push the value of the property and return 1,
+	// or return 0 if the property could not be fetched. nameFS is null if the name is not a FixedString.
+	template <class TFetch>
+	int LuaFetchProperties(lua_State * L, int namesIndex, TFetch fetch)
+	{
+		luaL_checktype(L, namesIndex, LUA_TTABLE);
+		lua_newtable(L);
+		auto resultIndex = lua_gettop(L);
+
+		lua_pushnil(L);
+		while (lua_next(L, namesIndex) != 0) {
+			if (lua_type(L, -1) != LUA_TSTRING) {
+				return luaL_error(L, "Property names must be strings");
+			}
+
+			auto name = lua_tostring(L, -1);
+			if (fetch(name, LuaToFixedString(L, -1)) > 0) {
+				lua_setfield(L, resultIndex, name);
+			}
+
+			lua_pop(L, 1);
+		}
+
+		return 1;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace dse
+{
+	constexpr std::string_view OsiToolsOnlyBegin = "/* [OSITOOLS_ONLY]";
+	constexpr std::string_view OsiToolsOnlyEnd = "*/";
+	constexpr std::string_view NoOsiToolsBegin = "// [BEGIN_NO_OSITOOLS]";
+	constexpr std::string_view NoOsiToolsEnd = "// [END_NO_OSITOOLS]";
+	constexpr std::string_view CompileTraceOption = "option compile_trace\r\n";
+
+	// Applies the story preprocessor markers (see "Preprocessor" in APIDocs.md) to the story source
+	// and blanks the compile_trace option.
+	// Only depends on the standard library, so it can be tested without the game (see Tests/).
+	template <class TString>
+	void PreprocessStorySource(std::string_view original, TString & postProcessed, bool processMarkers)
+	{
+		postProcessed.clear();
+		postProcessed.reserve(original.size());
+
+		// Clear compile trace flags to avoid large compile traces
+		auto compileTracePos = original.find(CompileTraceOption);
+		auto compileTraceEnd = (compileTracePos != std::string_view::npos)
+			? compileTracePos + CompileTraceOption.size() - 2
+			: std::string_view::npos;
+
+		// Copies a range of the original story, blanking the part of the compile_trace option that falls into it
+		auto emit = [&](TString & out, std::size_t from, std::size_t to) {
+			auto outPos = out.size();
+			out.append(original.data() + from, to - from);
+			auto blankFrom = std::max(from, compileTracePos);
+			auto blankTo = std::min(to, compileTraceEnd);
+			if (blankFrom < blankTo) {
+				memset(out.data() + outPos + (blankFrom - from), ' ', blankTo - blankFrom);
+			}
+		};
+
+		if (!processMarkers) {
+			emit(postProcessed, 0, original.size());
+			return;
+		}
+
+		// [OSITOOLS_ONLY] blocks are unwrapped first, and [BEGIN_NO_OSITOOLS] ranges are removed
+		// from the unwrapped text. If a marker has no matching end marker, the rest of the story
+		// is left untouched by that marker type.
+		TString unwrapped;
+		unwrapped.reserve(original.size());
+		std::size_t pos = 0;
+		while (pos < original.size()) {
+			auto next = original.find(OsiToolsOnlyBegin, pos);
+			if (next == std::string_view::npos) break;
+
+			auto end = original.find(OsiToolsOnlyEnd, next);
+			if (end == std::string_view::npos) break;
+
+			// Strip the marker and the whitespace character following it
+			emit(unwrapped, pos, next);
+			emit(unwrapped, std::min(next + OsiToolsOnlyBegin.size() + 1, end), end);
+			pos = end + OsiToolsOnlyEnd.size();
+		}
+
+		emit(unwrapped, pos, original.size());
+
+		std::string_view phase1(unwrapped.data(), unwrapped.size());
+		pos = 0;
+		while (pos < phase1.size()) {
+			auto next = phase1.find(NoOsiToolsBegin, pos);
+			if (next == std::string_view::npos) break;
+
+			auto end = phase1.find(NoOsiToolsEnd, next);
+			if (end == std::string_view::npos) break;
+
+			// Remove everything up to and including the end marker and the newline following it
+			postProcessed.append(phase1.data() + pos, next - pos);
+			pos = end + NoOsiToolsEnd.size() + 1;
+		}
+
+		if (pos < phase1.size()) {
+			postProcessed.append(phase1.data() + pos, phase1.size() - pos);
+		}
+	}
+}
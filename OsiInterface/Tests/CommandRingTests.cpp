@@ -0,0 +1,301 @@
+#include "CommandRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dse;
+
+static int gFailures = 0;
+
+#define CHECK(expr) \
+	do { \
+		if (!(expr)) { \
+			fprintf(stderr, "%s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); \
+			gFailures++; \
+		} \
+	} while (0)
+
+// Same shape as Debugger::Command: a type tag and a few POD fields
+struct TestCommand
+{
+	uint32_t Type;
+	uint32_t Seq;
+	uint64_t Payload;
+};
+
+static uint64_t MakePayload(uint32_t seq)
+{
+	return (uint64_t)seq * 0x9E3779B97F4A7C15ull;
+}
+
+static void TestEmptyAndFull()
+{
+	CommandRing<TestCommand, 8> ring;
+	std::size_t slot;
+	CHECK(!ring.Peek(slot));
+
+	for (uint32_t i = 0; i < 8; i++) {
+		CHECK(ring.TryReserve(slot));
+		ring[slot] = { 1, i, MakePayload(i) };
+		ring.Publish();
+	}
+
+	CHECK(!ring.TryReserve(slot));
+
+	CHECK(ring.Peek(slot));
+	CHECK(ring[slot].Seq == 0);
+	ring.Consume();
+
+	// The freed slot is reused for the next command
+	CHECK(ring.TryReserve(slot));
+	ring[slot] = { 1, 8, MakePayload(8) };
+	ring.Publish();
+	CHECK(!ring.TryReserve(slot));
+
+	for (uint32_t i = 1; i <= 8; i++) {
+		CHECK(ring.Peek(slot));
+		CHECK(ring[slot].Seq == i);
+		CHECK(ring[slot].Payload == MakePayload(i));
+		ring.Consume();
+	}
+
+	CHECK(!ring.Peek(slot));
+}
+
+static void TestReserveWithoutPublish()
+{
+	CommandRing<TestCommand, 4> ring;
+	std::size_t slot, reserved;
+	CHECK(ring.TryReserve(reserved));
+	ring[reserved] = { 1, 0, 0 };
+	// Reserving doesn't make the entry visible to the consumer
+	CHECK(!ring.Peek(slot));
+	// and the same slot is returned until it is published
+	CHECK(ring.TryReserve(slot));
+	CHECK(slot == reserved);
+	ring.Publish();
+	CHECK(ring.Peek(slot));
+	CHECK(slot == reserved);
+}
+
+// Commands must arrive complete and in order when the producer and consumer run concurrently
+static void TestConcurrentProducerConsumer()
+{
+	constexpr uint32_t numCommands = 1000000;
+	CommandRing<TestCommand, 64> ring;
+
+	std::thread producer([&ring]() {
+		for (uint32_t i = 0; i < numCommands; i++) {
+			std::size_t slot;
+			while (!ring.TryReserve(slot)) {
+				std::this_thread::yield();
+			}
+
+			ring[slot] = { i % 3, i, MakePayload(i) };
+			ring.Publish();
+		}
+	});
+
+	uint32_t expected = 0, errors = 0;
+	while (expected < numCommands) {
+		std::size_t slot;
+		if (!ring.Peek(slot)) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		auto const & command = ring[slot];
+		if (command.Seq != expected || command.Type != expected % 3 || command.Payload != MakePayload(expected)) {
+			errors++;
+		}
+
+		ring.Consume();
+		expected++;
+	}
+
+	producer.join();
+	CHECK(errors == 0);
+	std::size_t slot;
+	CHECK(!ring.Peek(slot));
+}
+
+// Queue of closures, as used by the debugger before the command ring
+class ClosureQueue
+{
+public:
+	void Push(std::function<void ()> && fn)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		queue_.push_back(std::move(fn));
+	}
+
+	bool TryPop(std::function<void ()> & fn)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (queue_.empty()) return false;
+		fn = std::move(queue_.front());
+		queue_.pop_front();
+		return true;
+	}
+
+private:
+	std::mutex mutex_;
+	std::deque<std::function<void ()>> queue_;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double BenchmarkRingThroughput(uint32_t numCommands)
+{
+	CommandRing<TestCommand, 64> ring;
+	auto start = Clock::now();
+	std::thread producer([&ring, numCommands]() {
+		for (uint32_t i = 0; i < numCommands; i++) {
+			std::size_t slot;
+			while (!ring.TryReserve(slot)) {
+				std::this_thread::yield();
+			}
+
+			ring[slot] = { 1, i, MakePayload(i) };
+			ring.Publish();
+		}
+	});
+
+	uint64_t sum = 0;
+	for (uint32_t received = 0; received < numCommands;) {
+		std::size_t slot;
+		if (ring.Peek(slot)) {
+			sum += ring[slot].Payload;
+			ring.Consume();
+			received++;
+		} else {
+			std::this_thread::yield();
+		}
+	}
+
+	producer.join();
+	auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	CHECK(sum != 0);
+	return numCommands / seconds;
+}
+
+static double BenchmarkClosureThroughput(uint32_t numCommands)
+{
+	ClosureQueue queue;
+	uint64_t sum = 0;
+	auto start = Clock::now();
+	std::thread producer([&queue, &sum, numCommands]() {
+		for (uint32_t i = 0; i < numCommands; i++) {
+			// Captures more than the small buffer of std::function, like the debugger's closures did
+			auto payload = MakePayload(i);
+			std::string name = "Evaluate";
+			queue.Push([&sum, payload, name]() { sum += payload + name.size(); });
+		}
+	});
+
+	std::function<void ()> fn;
+	for (uint32_t received = 0; received < numCommands;) {
+		if (queue.TryPop(fn)) {
+			fn();
+			received++;
+		} else {
+			std::this_thread::yield();
+		}
+	}
+
+	producer.join();
+	auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	CHECK(sum != 0);
+	return numCommands / seconds;
+}
+
+// Round trip of a command to the consumer thread and an acknowledgement back through a second ring
+static void BenchmarkRingLatency(uint32_t numRoundTrips)
+{
+	CommandRing<TestCommand, 64> requests, responses;
+	std::thread consumer([&]() {
+		for (uint32_t i = 0; i < numRoundTrips; i++) {
+			std::size_t slot;
+			while (!requests.Peek(slot)) {
+				std::this_thread::yield();
+			}
+
+			auto seq = requests[slot].Seq;
+			requests.Consume();
+
+			while (!responses.TryReserve(slot)) {
+				std::this_thread::yield();
+			}
+
+			responses[slot] = { 2, seq, 0 };
+			responses.Publish();
+		}
+	});
+
+	std::vector<double> latencies;
+	latencies.reserve(numRoundTrips);
+	for (uint32_t i = 0; i < numRoundTrips; i++) {
+		auto start = Clock::now();
+		std::size_t slot;
+		while (!requests.TryReserve(slot)) {
+			std::this_thread::yield();
+		}
+
+		requests[slot] = { 1, i, MakePayload(i) };
+		requests.Publish();
+
+		while (!responses.Peek(slot)) {
+			std::this_thread::yield();
+		}
+
+		CHECK(responses[slot].Seq == i);
+		responses.Consume();
+		latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+	}
+
+	consumer.join();
+	std::sort(latencies.begin(), latencies.end());
+	printf("Command ring round trip: median %.0f ns, 99th percentile %.0f ns\n",
+		latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100]);
+}
+
+// Usage: CommandRingTests [--bench <commands>]
+// Timings are informational only. Both sides yield while waiting, so on a single core
+// the latency is dominated by the scheduler.
+int main(int argc, char ** argv)
+{
+	uint32_t benchCommands = 0;
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--bench" && i + 1 < argc) {
+			benchCommands = (uint32_t)atoi(argv[++i]);
+		}
+	}
+
+	TestEmptyAndFull();
+	TestReserveWithoutPublish();
+	TestConcurrentProducerConsumer();
+
+	if (benchCommands > 0) {
+		auto ringRate = BenchmarkRingThroughput(benchCommands);
+		auto closureRate = BenchmarkClosureThroughput(benchCommands);
+		printf("Throughput: command ring %.1f M/s, locked closure queue %.1f M/s\n",
+			ringRate / 1e6, closureRate / 1e6);
+		BenchmarkRingLatency(std::min(benchCommands, 100000u));
+	}
+
+	if (gFailures > 0) {
+		fprintf(stderr, "%d check(s) failed\n", gFailures);
+		return 1;
+	}
+
+	printf("All command ring tests passed\n");
+	return 0;
+}
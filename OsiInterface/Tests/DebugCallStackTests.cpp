@@ -0,0 +1,219 @@
+#include "DebugCallStack.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace dse;
+
+static int gFailures = 0;
+
+#define CHECK(expr) \
+	do { \
+		if (!(expr)) { \
+			fprintf(stderr, "%s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); \
+			gFailures++; \
+		} \
+	} while (0)
+
+// Keeps the hooks from being inlined into the benchmark loop, as the real hooks are called through the node VMT wrappers
+#if defined(_MSC_VER)
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
+
+static CallStackFrame MakeFrame(uint32_t index)
+{
+	CallStackFrame frame{};
+	frame.frameType = (BreakpointReason)(index % 8);
+	frame.node = reinterpret_cast<Node *>((uintptr_t)(index + 1) * 64);
+	frame.actionIndex = index;
+	return frame;
+}
+
+static bool FramesEqual(CallStackFrame const & a, CallStackFrame const & b)
+{
+	return a.frameType == b.frameType
+		&& a.node == b.node
+		&& a.goal == b.goal
+		&& a.actionIndex == b.actionIndex
+		&& a.tupleLL == b.tupleLL
+		&& a.tuplePtrLL == b.tuplePtrLL;
+}
+
+static void TestPushPop()
+{
+	DebugCallStack stack;
+	CHECK(stack.Empty());
+	CHECK(stack.NumFrames() == 0);
+	CHECK(stack.begin() == stack.end());
+
+	for (uint32_t i = 0; i < 10; i++) {
+		stack.Push(MakeFrame(i));
+		CHECK(FramesEqual(stack.Top(), MakeFrame(i)));
+	}
+
+	CHECK(stack.Depth() == 10);
+	CHECK(stack.NumFrames() == 10);
+	CHECK(!stack.Overflowed());
+
+	uint32_t index = 0;
+	for (auto const & frame : stack) {
+		CHECK(FramesEqual(frame, MakeFrame(index++)));
+	}
+
+	CHECK(index == 10);
+
+	stack.Pop();
+	CHECK(FramesEqual(stack.Top(), MakeFrame(8)));
+	stack.Clear();
+	CHECK(stack.Empty());
+}
+
+static void TestOverflow()
+{
+	DebugCallStack stack;
+	auto const extra = 5u;
+	for (uint32_t i = 0; i < DebugCallStack::MaxDepth + extra; i++) {
+		stack.Push(MakeFrame(i));
+	}
+
+	// Frames past the capacity are only counted
+	CHECK(stack.Overflowed());
+	CHECK(stack.Depth() == DebugCallStack::MaxDepth + extra);
+	CHECK(stack.NumFrames() == DebugCallStack::MaxDepth);
+	CHECK(FramesEqual(stack[DebugCallStack::MaxDepth - 1], MakeFrame(DebugCallStack::MaxDepth - 1)));
+
+	for (uint32_t i = 0; i < extra; i++) {
+		stack.Pop();
+	}
+
+	// Once the overflowed frames are popped, the stored frames are intact again
+	CHECK(!stack.Overflowed());
+	CHECK(FramesEqual(stack.Top(), MakeFrame(DebugCallStack::MaxDepth - 1)));
+
+	for (uint32_t i = 0; i < DebugCallStack::MaxDepth; i++) {
+		stack.Pop();
+	}
+
+	CHECK(stack.Empty());
+}
+
+// Node enter/exit hooks, as done by Debugger::PushFrame()/PopFrame()
+// (the frame check on pop is included, as it runs on every hooked node exit)
+template <class TStack>
+struct HookRunner;
+
+template <>
+struct HookRunner<DebugCallStack>
+{
+	DebugCallStack Stack;
+
+	NOINLINE bool Enter(CallStackFrame const & frame)
+	{
+		Stack.Push(frame);
+		return !Stack.Overflowed();
+	}
+
+	NOINLINE bool Exit(CallStackFrame const & frame)
+	{
+		if (Stack.Overflowed()) {
+			Stack.Pop();
+			return true;
+		}
+
+		bool matches = FramesEqual(Stack.Top(), frame);
+		Stack.Pop();
+		return matches;
+	}
+};
+
+// Call stack used by the debugger before DebugCallStack
+template <>
+struct HookRunner<std::vector<CallStackFrame>>
+{
+	std::vector<CallStackFrame> Stack;
+
+	NOINLINE bool Enter(CallStackFrame const & frame)
+	{
+		Stack.push_back(frame);
+		return true;
+	}
+
+	NOINLINE bool Exit(CallStackFrame const & frame)
+	{
+		bool matches = FramesEqual(Stack.back(), frame);
+		Stack.pop_back();
+		return matches;
+	}
+};
+
+// Runs rule chains of the specified depth and returns the time per hooked node (enter + exit) in ns.
+// If fresh is set, a new stack is used for each chain, so the vector reallocates as it grows.
+template <class TStack>
+static double BenchmarkHooks(std::vector<CallStackFrame> const & frames, uint32_t chains, bool fresh)
+{
+	HookRunner<TStack> runner;
+	uint64_t mismatches = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t chain = 0; chain < chains; chain++) {
+		if (fresh) {
+			runner = HookRunner<TStack>();
+		}
+
+		for (auto const & frame : frames) {
+			runner.Enter(frame);
+		}
+
+		for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+			if (!runner.Exit(*it)) {
+				mismatches++;
+			}
+		}
+	}
+
+	auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	CHECK(mismatches == 0);
+	return ns / ((double)chains * frames.size());
+}
+
+// Usage: DebugCallStackTests [--bench <chains>]
+// Timings are informational only.
+int main(int argc, char ** argv)
+{
+	uint32_t benchChains = 0;
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--bench" && i + 1 < argc) {
+			benchChains = (uint32_t)atoi(argv[++i]);
+		}
+	}
+
+	TestPushPop();
+	TestOverflow();
+
+	if (benchChains > 0) {
+		for (uint32_t depth : { 16u, 256u }) {
+			std::vector<CallStackFrame> frames;
+			for (uint32_t i = 0; i < depth; i++) {
+				frames.push_back(MakeFrame(i));
+			}
+
+			printf("Depth %u: DebugCallStack %.2f ns/node, vector %.2f ns/node, vector from empty %.2f ns/node\n",
+				depth,
+				BenchmarkHooks<DebugCallStack>(frames, benchChains, false),
+				BenchmarkHooks<std::vector<CallStackFrame>>(frames, benchChains, false),
+				BenchmarkHooks<std::vector<CallStackFrame>>(frames, benchChains, true));
+		}
+	}
+
+	if (gFailures > 0) {
+		fprintf(stderr, "%d check(s) failed\n", gFailures);
+		return 1;
+	}
+
+	printf("All debugger call stack tests passed\n");
+	return 0;
+}
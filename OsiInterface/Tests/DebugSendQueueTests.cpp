@@ -0,0 +1,446 @@
+#include "DebugSendQueue.h"
+#include "osidebug.pb.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dse;
+
+static int gFailures = 0;
+
+#define CHECK(expr) \
+	do { \
+		if (!(expr)) { \
+			fprintf(stderr, "%s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); \
+			gFailures++; \
+		} \
+	} while (0)
+
+static bool WaitFor(std::function<bool ()> condition)
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!condition()) {
+		if (std::chrono::steady_clock::now() > deadline) {
+			return false;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return true;
+}
+
+// Records the frames written by the send queue; writes can be held back
+// to simulate a slow socket, or failed to simulate a disconnect.
+class MockTransport : public DebugTransport
+{
+public:
+	bool Write(uint8_t const * buf, uint32_t length) override
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		inWrite_++;
+		cv_.notify_all();
+		cv_.wait(lock, [this]() { return !blocked_; });
+		inWrite_--;
+		if (failWrites_) {
+			return false;
+		}
+
+		frames_.emplace_back(buf, buf + length);
+		return true;
+	}
+
+	int Read(uint8_t * /*buf*/, uint32_t /*length*/) override
+	{
+		return 0;
+	}
+
+	void Close() override
+	{
+		closed_ = true;
+	}
+
+	void Block()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		blocked_ = true;
+	}
+
+	void Unblock()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		blocked_ = false;
+		cv_.notify_all();
+	}
+
+	void FailWrites()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		failWrites_ = true;
+	}
+
+	bool WaitUntilInWrite()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		return cv_.wait_for(lock, std::chrono::seconds(5), [this]() { return inWrite_ > 0; });
+	}
+
+	bool IsClosed() const
+	{
+		return closed_;
+	}
+
+	std::vector<std::vector<uint8_t>> Frames()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		return frames_;
+	}
+
+	// Decodes the written frames and returns the sequence numbers of the messages in send order
+	std::vector<uint32_t> SequenceNumbers()
+	{
+		std::vector<uint32_t> seqNos;
+		for (auto const & frame : Frames()) {
+			uint32_t length;
+			CHECK(frame.size() >= 4);
+			memcpy(&length, frame.data(), 4);
+			CHECK(length == frame.size());
+
+			BackendToDebugger msg;
+			CHECK(msg.ParseFromArray(frame.data() + 4, (int)frame.size() - 4));
+			if (msg.msg_case() == BackendToDebugger::kBatch) {
+				for (auto const & batched : msg.batch().messages()) {
+					seqNos.push_back(batched.seq_no());
+				}
+			} else {
+				seqNos.push_back(msg.seq_no());
+			}
+		}
+
+		return seqNos;
+	}
+
+private:
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::vector<std::vector<uint8_t>> frames_;
+	unsigned inWrite_{ 0 };
+	bool blocked_{ false };
+	bool failWrites_{ false };
+	std::atomic<bool> closed_{ false };
+};
+
+static BackendToDebugger MakeMessage(uint32_t seqNo)
+{
+	BackendToDebugger msg;
+	msg.set_seq_no(seqNo);
+	msg.mutable_debugoutput()->set_message("Message " + std::to_string(seqNo));
+	return msg;
+}
+
+static std::vector<uint32_t> Sequence(uint32_t first, uint32_t count)
+{
+	std::vector<uint32_t> seqNos;
+	for (uint32_t i = 0; i < count; i++) {
+		seqNos.push_back(first + i);
+	}
+
+	return seqNos;
+}
+
+static void TestOrdering()
+{
+	MockTransport transport;
+	DebugSendQueue queue(16);
+	queue.Start(&transport);
+
+	for (uint32_t i = 0; i < 1000; i++) {
+		CHECK(queue.Enqueue(MakeMessage(i), DebugMessagePriority::Normal));
+	}
+
+	// Messages of each producer must be sent in the order they were queued
+	std::vector<std::thread> producers;
+	for (uint32_t producer = 1; producer <= 4; producer++) {
+		producers.emplace_back([&queue, producer]() {
+			for (uint32_t i = 0; i < 500; i++) {
+				queue.Enqueue(MakeMessage(producer * 1000 + i), DebugMessagePriority::Normal);
+			}
+		});
+	}
+
+	for (auto & producer : producers) {
+		producer.join();
+	}
+
+	queue.Stop();
+
+	auto seqNos = transport.SequenceNumbers();
+	CHECK(seqNos.size() == 3000);
+	CHECK(std::vector<uint32_t>(seqNos.begin(), seqNos.begin() + 1000) == Sequence(0, 1000));
+
+	for (uint32_t producer = 1; producer <= 4; producer++) {
+		std::vector<uint32_t> producerSeqNos;
+		for (auto seqNo : seqNos) {
+			if (seqNo / 1000 == producer) {
+				producerSeqNos.push_back(seqNo);
+			}
+		}
+
+		CHECK(producerSeqNos == Sequence(producer * 1000, 500));
+	}
+
+	auto stats = queue.GetStats();
+	CHECK(stats.FramesSent == 3000);
+	CHECK(stats.FramesDropped == 0);
+	CHECK(stats.BatchesSent == 0);
+	CHECK(stats.PeakDepth <= 16);
+}
+
+static void TestTraceDropWhenFull()
+{
+	MockTransport transport;
+	DebugSendQueue queue(2);
+	queue.Start(&transport);
+
+	transport.Block();
+	CHECK(queue.Enqueue(MakeMessage(0), DebugMessagePriority::Normal));
+	CHECK(transport.WaitUntilInWrite());
+	// The frame being written still occupies its slot
+	CHECK(queue.Enqueue(MakeMessage(1), DebugMessagePriority::Trace));
+	CHECK(!queue.Enqueue(MakeMessage(2), DebugMessagePriority::Trace));
+
+	auto stats = queue.GetStats();
+	CHECK(stats.FramesDropped == 1);
+	CHECK(stats.ProducerStalls == 0);
+	CHECK(stats.PeakDepth == 2);
+
+	transport.Unblock();
+	queue.Stop();
+	CHECK(transport.SequenceNumbers() == Sequence(0, 2));
+}
+
+static void TestProducerStall()
+{
+	MockTransport transport;
+	DebugSendQueue queue(2);
+	queue.Start(&transport);
+
+	transport.Block();
+	CHECK(queue.Enqueue(MakeMessage(0), DebugMessagePriority::Normal));
+	CHECK(transport.WaitUntilInWrite());
+	CHECK(queue.Enqueue(MakeMessage(1), DebugMessagePriority::Normal));
+
+	std::atomic<bool> enqueued{ false };
+	std::thread producer([&queue, &enqueued]() {
+		CHECK(queue.Enqueue(MakeMessage(2), DebugMessagePriority::Normal));
+		enqueued = true;
+	});
+
+	CHECK(WaitFor([&queue]() { return queue.GetStats().ProducerStalls == 1; }));
+	CHECK(!enqueued);
+
+	// Finishing the write must wake the waiting producer
+	transport.Unblock();
+	producer.join();
+	CHECK(enqueued);
+
+	queue.Stop();
+	CHECK(transport.SequenceNumbers() == Sequence(0, 3));
+	CHECK(queue.GetStats().FramesSent == 3);
+}
+
+static void TestWriteFailure()
+{
+	MockTransport transport;
+	DebugSendQueue queue(16);
+	std::vector<std::string> errors;
+	queue.SetErrorHandler([&errors](char const * message) {
+		errors.push_back(message);
+	});
+	queue.Start(&transport);
+
+	transport.FailWrites();
+	CHECK(queue.Enqueue(MakeMessage(0), DebugMessagePriority::Normal));
+	CHECK(WaitFor([&transport]() { return transport.IsClosed(); }));
+	CHECK(!queue.Enqueue(MakeMessage(1), DebugMessagePriority::Normal));
+
+	queue.Stop();
+	CHECK(errors.size() == 1);
+	CHECK(errors.size() == 1 && errors[0].find("Write failed") != std::string::npos);
+	CHECK(transport.Frames().empty());
+	CHECK(queue.GetStats().FramesSent == 0);
+}
+
+static void TestSerializeFailure()
+{
+	MockTransport transport;
+	DebugSendQueue queue(16);
+	std::vector<std::string> errors;
+	queue.SetErrorHandler([&errors](char const * message) {
+		errors.push_back(message);
+	});
+	queue.Start(&transport);
+
+	CHECK(queue.Enqueue(MakeMessage(0), DebugMessagePriority::Normal));
+	CHECK(!queue.Enqueue(16, [](uint8_t * /*buf*/, uint32_t /*size*/) { return false; }, DebugMessagePriority::Normal));
+	CHECK(queue.Enqueue(MakeMessage(1), DebugMessagePriority::Normal));
+	queue.Stop();
+
+	CHECK(errors.size() == 1);
+	CHECK(transport.SequenceNumbers() == Sequence(0, 2));
+	CHECK(queue.GetStats().FramesSent == 2);
+}
+
+static void TestRestartDiscardsStaleReservations()
+{
+	MockTransport transport1, transport2;
+	DebugSendQueue queue(16);
+	queue.Start(&transport1);
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool serializing = false, release = false;
+	auto msg = MakeMessage(0);
+	auto serialize = [&](uint8_t * buf, uint32_t size) {
+		std::unique_lock<std::mutex> lock(mutex);
+		serializing = true;
+		cv.notify_all();
+		cv.wait(lock, [&release]() { return release; });
+		return msg.SerializeToArray(buf, (int)size);
+	};
+
+	bool published = true;
+	std::thread producer([&]() {
+		published = queue.Enqueue((uint32_t)msg.ByteSizeLong(), serialize, DebugMessagePriority::Normal);
+	});
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cv.wait(lock, [&serializing]() { return serializing; });
+	}
+
+	// The slot reserved by the producer belongs to the previous session
+	queue.Stop();
+	queue.Start(&transport2);
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		release = true;
+		cv.notify_all();
+	}
+
+	producer.join();
+	CHECK(!published);
+
+	CHECK(queue.Enqueue(MakeMessage(1), DebugMessagePriority::Normal));
+	queue.Stop();
+
+	CHECK(transport1.Frames().empty());
+	CHECK(transport2.SequenceNumbers() == Sequence(1, 1));
+	auto stats = queue.GetStats();
+	CHECK(stats.FramesSent == 1);
+	CHECK(stats.PeakDepth == 1);
+}
+
+static void TestBatching()
+{
+	DebugBatchConfig config;
+	config.MaxBytes = 0x10000;
+	// Long enough that only a normal priority message or Stop() can flush the batch
+	config.FlushIntervalMs = 10000;
+
+	{
+		MockTransport transport;
+		DebugSendQueue queue(16, config);
+		queue.Start(&transport);
+		CHECK(queue.EnableBatching());
+
+		for (uint32_t i = 0; i < 5; i++) {
+			CHECK(queue.Enqueue(MakeMessage(i), DebugMessagePriority::Trace));
+		}
+
+		CHECK(queue.Enqueue(MakeMessage(5), DebugMessagePriority::Normal));
+		CHECK(WaitFor([&transport]() { return transport.Frames().size() == 1; }));
+
+		// Trace messages are held back until Stop()
+		CHECK(queue.Enqueue(MakeMessage(6), DebugMessagePriority::Trace));
+		CHECK(queue.Enqueue(MakeMessage(7), DebugMessagePriority::Trace));
+		auto stopStart = std::chrono::steady_clock::now();
+		queue.Stop();
+		CHECK(std::chrono::steady_clock::now() - stopStart < std::chrono::seconds(5));
+
+		CHECK(transport.Frames().size() == 2);
+		CHECK(transport.SequenceNumbers() == Sequence(0, 8));
+		auto stats = queue.GetStats();
+		CHECK(stats.FramesSent == 8);
+		CHECK(stats.BatchesSent == 2);
+
+		// Batching is reset by a new session
+		queue.Start(&transport);
+		CHECK(queue.Enqueue(MakeMessage(8), DebugMessagePriority::Trace));
+		CHECK(queue.Enqueue(MakeMessage(9), DebugMessagePriority::Trace));
+		queue.Stop();
+		CHECK(transport.SequenceNumbers() == Sequence(0, 10));
+		CHECK(queue.GetStats().BatchesSent == 0);
+	}
+
+	{
+		// Each frame is ~20 bytes, so batches are split after a few frames
+		config.MaxBytes = 64;
+		MockTransport transport;
+		DebugSendQueue queue(64, config);
+		queue.Start(&transport);
+		CHECK(queue.EnableBatching());
+
+		for (uint32_t i = 0; i < 40; i++) {
+			CHECK(queue.Enqueue(MakeMessage(i), DebugMessagePriority::Trace));
+		}
+
+		queue.Stop();
+		CHECK(transport.SequenceNumbers() == Sequence(0, 40));
+		for (auto const & frame : transport.Frames()) {
+			// The envelope adds a few bytes on top of the batched frames
+			CHECK(frame.size() <= config.MaxBytes + 16);
+		}
+
+		auto stats = queue.GetStats();
+		CHECK(stats.FramesSent == 40);
+		CHECK(stats.BatchesSent > 1);
+	}
+
+	{
+		config.MaxBytes = 0;
+		MockTransport transport;
+		DebugSendQueue queue(16, config);
+		queue.Start(&transport);
+		CHECK(!queue.EnableBatching());
+		queue.Stop();
+	}
+}
+
+int main()
+{
+	GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+	TestOrdering();
+	TestTraceDropWhenFull();
+	TestProducerStall();
+	TestWriteFailure();
+	TestSerializeFailure();
+	TestRestartDiscardsStaleReservations();
+	TestBatching();
+
+	if (gFailures > 0) {
+		fprintf(stderr, "%d check(s) failed\n", gFailures);
+		return 1;
+	}
+
+	printf("All DebugSendQueue tests passed\n");
+	return 0;
+}
@@ -0,0 +1,274 @@
+#include "StoryPreprocessor.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace dse;
+
+static int gFailures = 0;
+
+// Original preprocessor implementation, kept as the reference.
+// Sets malformed if the input hits its duplication bug: when "*/" immediately follows
+// the [OSITOOLS_ONLY] marker, substr() gets a negative length and copies the rest of the story.
+static std::string LegacyPreprocessStory(std::string original, bool processMarkers, bool & malformed)
+{
+	malformed = false;
+
+	auto debugPos = original.find("option compile_trace\r\n");
+	if (debugPos != std::string::npos) {
+		for (std::size_t i = debugPos; i < debugPos + 20; i++) {
+			original[i] = ' ';
+		}
+	}
+
+	if (!processMarkers) {
+		return original;
+	}
+
+	std::string ph1, postProcessed;
+	ph1.reserve(original.size());
+	postProcessed.reserve(original.size());
+
+	std::size_t pos = 0;
+	while (pos < original.size()) {
+		auto next = original.find("/* [OSITOOLS_ONLY]", pos);
+		if (next == std::string::npos) {
+			ph1 += original.substr(pos);
+			break;
+		}
+
+		auto end = original.find("*/", next);
+		if (end == std::string::npos) {
+			ph1 += original.substr(pos);
+			break;
+		}
+
+		if (end < next + 19) {
+			malformed = true;
+		}
+
+		ph1 += original.substr(pos, next - pos);
+		ph1 += original.substr(next + 19, end - next - 19);
+		pos = end + 2;
+	}
+
+	pos = 0;
+	while (pos < ph1.size()) {
+		auto next = ph1.find("// [BEGIN_NO_OSITOOLS]", pos);
+		if (next == std::string::npos) {
+			postProcessed += ph1.substr(pos);
+			break;
+		}
+
+		auto end = ph1.find("// [END_NO_OSITOOLS]", next);
+		if (end == std::string::npos) {
+			postProcessed += ph1.substr(pos);
+			break;
+		}
+
+		postProcessed += ph1.substr(pos, next - pos);
+		pos = end + 21;
+	}
+
+	return postProcessed;
+}
+
+static std::string EscapeForLog(std::string const & s)
+{
+	std::string escaped;
+	for (auto c : s) {
+		if (c == '\r') {
+			escaped += "\\r";
+		} else if (c == '\n') {
+			escaped += "\\n";
+		} else {
+			escaped += c;
+		}
+	}
+
+	return escaped;
+}
+
+static unsigned gMalformedInputs = 0;
+
+static bool CheckEquivalent(std::string const & story, char const * source)
+{
+	bool equivalent = true;
+	for (auto processMarkers : { true, false }) {
+		bool malformed;
+		auto expected = LegacyPreprocessStory(story, processMarkers, malformed);
+		if (malformed) {
+			gMalformedInputs++;
+			continue;
+		}
+
+		std::string actual;
+		PreprocessStorySource(story, actual, processMarkers);
+		if (actual != expected) {
+			if (story.size() < 1000) {
+				fprintf(stderr, "%s (markers %s): Output mismatch\n  input:    \"%s\"\n  expected: \"%s\"\n  actual:   \"%s\"\n",
+					source, processMarkers ? "on" : "off", EscapeForLog(story).c_str(),
+					EscapeForLog(expected).c_str(), EscapeForLog(actual).c_str());
+			} else {
+				fprintf(stderr, "%s (markers %s): Output mismatch\n", source, processMarkers ? "on" : "off");
+			}
+
+			gFailures++;
+			equivalent = false;
+		}
+	}
+
+	return equivalent;
+}
+
+static std::string const ExampleStory =
+	"Version 1\r\n"
+	"SubGoalCombiner SGC_AND\r\n"
+	"INITSECTION\r\n"
+	"option compile_trace\r\n"
+	"KBSECTION\r\n"
+	"IF\r\n"
+	"TextEventSet(\"preprocessor\")\r\n"
+	"THEN\r\n"
+	"/* [OSITOOLS_ONLY]\r\n"
+	"DebugBreak(\"This code only runs if OsiTools is loaded\");\r\n"
+	"*/\r\n"
+	"DebugBreak(\"This always runs\");\r\n"
+	"// [BEGIN_NO_OSITOOLS]\r\n"
+	"DebugBreak(\"This only runs if OsiTools is *NOT* loaded\");\r\n"
+	"// [END_NO_OSITOOLS]\r\n"
+	"// Regular comment\r\n"
+	"/* Regular block comment */\r\n"
+	"EXITSECTION\r\n"
+	"ENDEXITSECTION\r\n";
+
+static void TestExampleStory()
+{
+	CheckEquivalent(ExampleStory, "Example story");
+
+	std::string processed;
+	PreprocessStorySource(ExampleStory, processed, true);
+	if (processed.find("OsiTools is loaded") == std::string::npos
+		|| processed.find("*NOT* loaded") != std::string::npos
+		|| processed.find("option compile_trace") != std::string::npos) {
+		fprintf(stderr, "Example story: Markers were not applied\n");
+		gFailures++;
+	}
+}
+
+// Random mixes of complete and truncated markers, regular comments, newlines and text
+static void TestRandomizedMarkers()
+{
+	static char const * const fragments[] = {
+		"/* [OSITOOLS_ONLY]", "/* [OSITOOLS_ONLY]\r\n", "/* [OSITOOLS_ONLY]\n", "/* [OSITOOLS_ONLY]*/", "*/", "*/\r\n",
+		"// [BEGIN_NO_OSITOOLS]", "// [BEGIN_NO_OSITOOLS]\r\n", "// [END_NO_OSITOOLS]", "// [END_NO_OSITOOLS]\r\n",
+		"// [END_NO_OSITOOLS]\n", "/* [OSITOOLS", "// [BEGIN_NO", "// [END_NO", "/", "//", "/*", "*", " ", "\r\n", "\n",
+		"DB_Test(1);", "IF", "THEN", "option compile_trace\r\n", "option compile_trace", "x"
+	};
+	constexpr std::size_t numFragments = sizeof(fragments) / sizeof(fragments[0]);
+
+	std::mt19937 rng(1234);
+	unsigned mismatches = 0;
+	for (unsigned i = 0; i < 200000 && mismatches < 10; i++) {
+		std::string story;
+		auto length = rng() % 24;
+		for (unsigned j = 0; j < length; j++) {
+			story += fragments[rng() % numFragments];
+		}
+
+		if (!CheckEquivalent(story, "Randomized story")) {
+			mismatches++;
+		}
+	}
+}
+
+static std::string MakeSyntheticStory(std::size_t size)
+{
+	std::string story;
+	story.reserve(size + ExampleStory.size());
+	unsigned i = 0;
+	while (story.size() < size) {
+		if (i++ % 8 == 0) {
+			story += ExampleStory;
+		} else {
+			story += "IF\r\nDB_Something((CHARACTERGUID)_Char, 1)\r\nAND\r\nNOT DB_Other(_Char)\r\nTHEN\r\nDB_Other(_Char);\r\n\r\n";
+		}
+	}
+
+	return story;
+}
+
+// Reports the speed of both implementations; timings are informational only
+static void BenchmarkSyntheticStory(std::size_t size)
+{
+	auto story = MakeSyntheticStory(size);
+	CheckEquivalent(story, "Synthetic story");
+
+	using clock = std::chrono::steady_clock;
+	constexpr unsigned iterations = 5;
+	std::string output;
+	bool malformed;
+	auto legacyStart = clock::now();
+	for (unsigned i = 0; i < iterations; i++) {
+		output = LegacyPreprocessStory(story, true, malformed);
+	}
+	auto legacyTime = std::chrono::duration<double, std::milli>(clock::now() - legacyStart).count() / iterations;
+
+	auto currentStart = clock::now();
+	for (unsigned i = 0; i < iterations; i++) {
+		PreprocessStorySource(story, output, true);
+	}
+	auto currentTime = std::chrono::duration<double, std::milli>(clock::now() - currentStart).count() / iterations;
+
+	printf("Synthetic %.1f MB story: original %.2f ms, current %.2f ms (%.1fx)\n",
+		story.size() / (1024.0 * 1024.0), legacyTime, currentTime, legacyTime / currentTime);
+}
+
+// Usage: StoryPreprocessorTests [--bench <MB>] [story files...]
+// Story files (eg. story_ac.div from a story build) are checked against the reference implementation.
+int main(int argc, char ** argv)
+{
+	std::size_t benchSize = 4;
+	std::vector<char const *> storyFiles;
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "--bench" && i + 1 < argc) {
+			benchSize = (std::size_t)atoi(argv[++i]);
+		} else {
+			storyFiles.push_back(argv[i]);
+		}
+	}
+
+	TestExampleStory();
+	TestRandomizedMarkers();
+
+	for (auto path : storyFiles) {
+		std::ifstream f(path, std::ios::in | std::ios::binary);
+		if (!f.good()) {
+			fprintf(stderr, "Could not open story file '%s'\n", path);
+			gFailures++;
+			continue;
+		}
+
+		std::stringstream ss;
+		ss << f.rdbuf();
+		if (CheckEquivalent(ss.str(), path)) {
+			printf("%s: Output matches\n", path);
+		}
+	}
+
+	BenchmarkSyntheticStory(benchSize * 1024 * 1024);
+	printf("Skipped %u inputs that trigger the duplication bug of the original implementation\n", gMalformedInputs);
+
+	if (gFailures > 0) {
+		fprintf(stderr, "%d check(s) failed\n", gFailures);
+		return 1;
+	}
+
+	printf("All story preprocessor tests passed\n");
+	return 0;
+}
@@ -16,6 +16,20 @@ void ConfigGetBool(Json::Value & node, char const * key, bool & value)
 	}
 }
 
+void ConfigGetUInt(Json::Value & node, char const * key, uint32_t & value)
+{
+	auto configVar = node[key];
+	if (!configVar.isNull()) {
+		if (configVar.isUInt()) {
+			value = configVar.asUInt();
+		} else {
+			std::stringstream err;
+			err << "Config option '" << key << "' should be an integer.";
+			Fail(err.str().c_str());
+		}
+	}
+}
+
 void LoadConfig(std::wstring const & configPath, dse::ToolConfig & config)
 {
 	std::ifstream f(configPath, std::ios::in);
@@ -36,6 +50,7 @@ void LoadConfig(std::wstring const & configPath, dse::ToolConfig & config)
 
 	ConfigGetBool(root, "CreateConsole", config.CreateConsole);
 	ConfigGetBool(root, "EnableLogging", config.EnableLogging);
+	ConfigGetBool(root, "BinaryLogging", config.BinaryLogging);
 	ConfigGetBool(root, "LogCompile", config.LogCompile);
 	ConfigGetBool(root, "EnableExtensions", config.EnableExtensions);
 	ConfigGetBool(root, "SendCrashReports", config.SendCrashReports);
@@ -45,6 +60,7 @@ void LoadConfig(std::wstring const & configPath, dse::ToolConfig & config)
 	ConfigGetBool(root, "DisableModValidation", config.DisableModValidation);
 	ConfigGetBool(root, "DeveloperMode", config.DeveloperMode);
 	ConfigGetBool(root, "EnableAchievements", config.EnableAchievements);
+	ConfigGetBool(root, "EnableLuaBytecodeCache", config.EnableLuaBytecodeCache);
 
 	auto debuggerPort = root["DebuggerPort"];
 	if (!debuggerPort.isNull()) {
@@ -55,6 +71,9 @@ void LoadConfig(std::wstring const & configPath, dse::ToolConfig & config)
 		}
 	}
 
+	ConfigGetUInt(root, "DebuggerBatchSize", config.DebuggerBatchSize);
+	ConfigGetUInt(root, "DebuggerFlushInterval", config.DebuggerFlushInterval);
+
 	auto flags = root["DebugFlags"];
 	if (!flags.isNull()) {
 		if (flags.isUInt()) {
@@ -0,0 +1,311 @@
+#include "../OsiInterface/OsirisTraceFormat.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace dse;
+
+struct NodeInfo
+{
+	uint8_t Type;
+	uint8_t Arity;
+	std::string Name;
+};
+
+char const * NodeTypeNames[] = {
+	"None", "Database", "Proc", "DivQuery", "And", "NotAnd", "RelOp", "Rule", "InternalQuery", "UserQuery"
+};
+
+char const * EventTypeNames[] = {
+	"IsValid", "PushDown", "PushDownDelete", "Insert", "Delete", "CallQuery"
+};
+
+char const * InputTypeNames[] = {
+	"InputEvent", "InputInsert", "InputDelete"
+};
+
+// Osiris ValueType IDs
+enum ColumnType : uint8_t
+{
+	ColNone = 0,
+	ColInteger = 1,
+	ColInteger64 = 2,
+	ColReal = 3,
+	ColUndefined = 0x7f
+};
+
+class TraceDecoder
+{
+public:
+	TraceDecoder(std::ostream & out)
+		: out_(out)
+	{}
+
+	bool Decode(std::istream & in)
+	{
+		TraceFileHeader header;
+		if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+			std::cerr << "Trace file is truncated" << std::endl;
+			return false;
+		}
+
+		if (header.Magic != TraceFileMagic) {
+			std::cerr << "Not an Osiris trace file" << std::endl;
+			return false;
+		}
+
+		if (header.Version != TraceFileVersion) {
+			std::cerr << "Unsupported trace version " << header.Version
+				<< " (expected " << TraceFileVersion << ")" << std::endl;
+			return false;
+		}
+
+		std::vector<uint8_t> payload;
+		TraceRecordHeader record;
+		while (in.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+			payload.resize(record.Size);
+			if (record.Size > 0 && !in.read(reinterpret_cast<char *>(payload.data()), record.Size)) {
+				std::cerr << "Trace file is truncated; last record is incomplete" << std::endl;
+				return false;
+			}
+
+			if (!DecodeRecord(record.Type, payload)) {
+				return false;
+			}
+		}
+
+		if (droppedRecords_ > 0) {
+			std::cerr << droppedRecords_ << " records were dropped during tracing" << std::endl;
+		}
+
+		return true;
+	}
+
+private:
+	std::ostream & out_;
+	std::unordered_map<uint32_t, std::string> strings_;
+	std::unordered_map<uint32_t, NodeInfo> nodes_;
+	uint64_t droppedRecords_{ 0 };
+
+	template <class T>
+	static bool Read(std::vector<uint8_t> const & buf, std::size_t & pos, T & value)
+	{
+		if (pos + sizeof(T) > buf.size()) return false;
+		memcpy(&value, buf.data() + pos, sizeof(T));
+		pos += sizeof(T);
+		return true;
+	}
+
+	bool DecodeRecord(TraceRecordType type, std::vector<uint8_t> const & payload)
+	{
+		std::size_t pos = 0;
+		switch (type) {
+		case TraceRecordType::StringDef:
+		{
+			uint32_t id;
+			if (!Read(payload, pos, id)) return Malformed("StringDef");
+			strings_[id] = std::string(payload.begin() + pos, payload.end());
+			return true;
+		}
+
+		case TraceRecordType::NodeDef:
+		{
+			uint32_t id;
+			NodeInfo node;
+			if (!Read(payload, pos, id)
+				|| !Read(payload, pos, node.Type)
+				|| !Read(payload, pos, node.Arity)) {
+				return Malformed("NodeDef");
+			}
+
+			node.Name = std::string(payload.begin() + pos, payload.end());
+			nodes_[id] = node;
+			return true;
+		}
+
+		case TraceRecordType::Event:
+			return DecodeEvent(payload);
+
+		case TraceRecordType::Input:
+			return DecodeInput(payload);
+
+		case TraceRecordType::Dropped:
+		{
+			uint32_t count;
+			if (!Read(payload, pos, count)) return Malformed("Dropped");
+			out_ << "*** " << count << " records dropped ***" << std::endl;
+			droppedRecords_ += count;
+			return true;
+		}
+
+		default:
+			// Skip unknown records so newer writers stay readable
+			return true;
+		}
+	}
+
+	bool DecodeEvent(std::vector<uint8_t> const & payload)
+	{
+		std::size_t pos = 0;
+		uint32_t nodeId;
+		uint8_t eventType, numColumns;
+		if (!Read(payload, pos, nodeId)
+			|| !Read(payload, pos, eventType)
+			|| !Read(payload, pos, numColumns)) {
+			return Malformed("Event");
+		}
+
+		if (eventType < sizeof(EventTypeNames) / sizeof(*EventTypeNames)) {
+			out_ << "[" << EventTypeNames[eventType] << "] ";
+		} else {
+			out_ << "[Event" << (unsigned)eventType << "] ";
+		}
+
+		DecodeNode(nodeId);
+		return DecodeColumns(payload, pos, numColumns, "Event column");
+	}
+
+	bool DecodeInput(std::vector<uint8_t> const & payload)
+	{
+		std::size_t pos = 0;
+		uint8_t inputType, numColumns;
+		uint32_t targetId;
+		if (!Read(payload, pos, inputType)
+			|| !Read(payload, pos, targetId)
+			|| !Read(payload, pos, numColumns)) {
+			return Malformed("Input");
+		}
+
+		if (inputType < sizeof(InputTypeNames) / sizeof(*InputTypeNames)) {
+			out_ << "[" << InputTypeNames[inputType] << "] ";
+		} else {
+			out_ << "[Input" << (unsigned)inputType << "] ";
+		}
+
+		if (inputType == (uint8_t)TraceInputType::Event) {
+			// Function handles can't be resolved without the story
+			out_ << "Function 0x" << std::hex << targetId << std::dec;
+		} else {
+			DecodeNode(targetId);
+		}
+
+		return DecodeColumns(payload, pos, numColumns, "Input column");
+	}
+
+	void DecodeNode(uint32_t nodeId)
+	{
+		out_ << "Node " << nodeId;
+		auto nodeIt = nodes_.find(nodeId);
+		if (nodeIt != nodes_.end()) {
+			auto const & node = nodeIt->second;
+			out_ << " ";
+			if (node.Type < sizeof(NodeTypeNames) / sizeof(*NodeTypeNames)) {
+				out_ << NodeTypeNames[node.Type];
+			}
+
+			if (!node.Name.empty()) {
+				out_ << " (" << node.Name << "/" << (unsigned)node.Arity << ")";
+			}
+		}
+	}
+
+	bool DecodeColumns(std::vector<uint8_t> const & payload, std::size_t & pos, unsigned numColumns, char const * what)
+	{
+		out_ << ": (";
+		for (unsigned i = 0; i < numColumns; i++) {
+			if (i > 0) out_ << ", ";
+			if (!DecodeColumn(payload, pos)) {
+				return Malformed(what);
+			}
+		}
+
+		out_ << ")" << std::endl;
+		return true;
+	}
+
+	bool DecodeColumn(std::vector<uint8_t> const & payload, std::size_t & pos)
+	{
+		uint8_t type;
+		if (!Read(payload, pos, type)) return false;
+
+		switch (type) {
+		case ColNone:
+		case ColUndefined:
+			out_ << "_";
+			return true;
+
+		case ColInteger:
+		{
+			int32_t value;
+			if (!Read(payload, pos, value)) return false;
+			out_ << value;
+			return true;
+		}
+
+		case ColInteger64:
+		{
+			int64_t value;
+			if (!Read(payload, pos, value)) return false;
+			out_ << value << "L";
+			return true;
+		}
+
+		case ColReal:
+		{
+			float value;
+			if (!Read(payload, pos, value)) return false;
+			out_ << value;
+			return true;
+		}
+
+		default:
+		{
+			uint32_t stringId;
+			if (!Read(payload, pos, stringId)) return false;
+			auto it = strings_.find(stringId);
+			if (it != strings_.end()) {
+				out_ << "\"" << it->second << "\"";
+			} else {
+				out_ << "<string #" << stringId << ">";
+			}
+			return true;
+		}
+		}
+	}
+
+	bool Malformed(char const * what)
+	{
+		std::cerr << "Malformed " << what << " record" << std::endl;
+		return false;
+	}
+};
+
+int main(int argc, char ** argv)
+{
+	if (argc < 2 || argc > 3) {
+		std::cerr << "Usage: OsirisTraceDecoder <trace file> [<output file>]" << std::endl;
+		return 1;
+	}
+
+	std::ifstream in(argv[1], std::ios::in | std::ios::binary);
+	if (!in.good()) {
+		std::cerr << "Could not open trace file: " << argv[1] << std::endl;
+		return 2;
+	}
+
+	std::ofstream outFile;
+	if (argc == 3) {
+		outFile.open(argv[2], std::ios::out);
+		if (!outFile.good()) {
+			std::cerr << "Could not open output file: " << argv[2] << std::endl;
+			return 2;
+		}
+	}
+
+	TraceDecoder decoder(argc == 3 ? outFile : std::cout);
+	return decoder.Decode(in) ? 0 : 3;
+}